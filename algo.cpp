@@ -6,7 +6,8 @@ bool func_to_mgraph(
     mutable_graph_t *mg,
     gnodemap_t &node_map,
     qflow_chart_t *fc,
-    bool append_node_id)
+    bool append_node_id,
+    const fctext_t *ft)
 {
   // Build function's flowchart (if needed)
   qflow_chart_t _fc;
@@ -17,6 +18,17 @@ bool func_to_mgraph(
       return false;
   }
 
+  // Render the function's text at once (if needed)
+  fctext_t _ft;
+  if (ft == NULL)
+  {
+    _ft.build(*fc);
+    ft = &_ft;
+  }
+
+  // A temporary text cannot be referenced by the nodes
+  bool ref_text = ft != &_ft && !append_node_id;
+
   // Resize the graph
   int nodes_count = fc->size();
   mg->resize(nodes_count);
@@ -24,18 +36,17 @@ bool func_to_mgraph(
   // Build the node cache and edges
   for (int nid=0; nid < nodes_count; nid++)
   {
-    qbasic_block_t &block = fc->blocks[nid];
     gnode_t *nc = node_map.add(nid);
 
     // Append node ID to the output
     if (append_node_id)
       nc->text.sprnt("ID(%d)\n", nid);
 
-    // Generate disassembly text
-    get_disasm_text(
-        block.startEA, 
-        block.endEA, 
-        &nc->text);
+    // Point to or copy the disassembly text
+    if (ref_text)
+      nc->text_ref = ft->get_text(nid);
+    else
+      nc->text.append(ft->get_text(nid));
 
     // Build edges
     for (int nid_succ=0, succ_sz=fc->nsucc(nid); nid_succ < succ_sz; nid_succ++)
@@ -148,6 +159,245 @@ void build_groupman_from_3dvec(
   }
 }
 
+//--------------------------------------------------------------------------
+/**
+* @brief Build the group manager from a 3d int vec and name the super groups.
+*        Empty names keep the default super group name
+*/
+static void build_groupman_from_named_3dvec(
+  qflow_chart_t *fc,
+  int_3dvec_t &path,
+  const qstrvec_t &sg_names,
+  groupman_t *gm,
+  bool sanitize)
+{
+  build_groupman_from_3dvec(fc, path, gm, false);
+
+  size_t isg = 0;
+  psupergroup_listp_t sgl = gm->get_path_sgl();
+  for (supergroup_listp_t::iterator it=sgl->begin();
+       it != sgl->end() && isg < sg_names.size();
+       ++it, ++isg)
+  {
+    if (!sg_names[isg].empty())
+      (*it)->name = sg_names[isg];
+  }
+
+  if (sanitize)
+  {
+    if (sanitize_groupman(BADADDR, gm, fc))
+      gm->initialize_lookups();
+  }
+}
+
+//--------------------------------------------------------------------------
+void build_groupman_from_sese(
+  qflow_chart_t *fc,
+  int max_region_size,
+  groupman_t *gm,
+  bool sanitize)
+{
+  // Compute the region tree
+  fcgraph_t tmp;
+  const fcgraph_t &g = fccache_t::instance()->get_graph(*fc, tmp);
+
+  dominators_t doms;
+  sesetree_t pst;
+  if (!doms.build(g) || !pst.build(doms))
+  {
+    build_groupman_from_fc(fc, gm, sanitize);
+    return;
+  }
+
+  int_3dvec_t path;
+  intvec_t sg_regions;
+  pst.build_grouping(max_region_size, path, &sg_regions);
+
+  // Name the super groups after the region holding them
+  qstrvec_t sg_names;
+  for (size_t i=0; i < sg_regions.size(); i++)
+  {
+    const sese_region_t &region = pst[sg_regions[i]];
+    sg_names.push_back().sprnt("region_%a", fc->blocks[region.entry].startEA);
+  }
+
+  build_groupman_from_named_3dvec(fc, path, sg_names, gm, sanitize);
+}
+
+//--------------------------------------------------------------------------
+void build_groupman_from_loops(
+  qflow_chart_t *fc,
+  bool use_sccs,
+  groupman_t *gm,
+  bool sanitize)
+{
+  fcgraph_t tmp;
+  const fcgraph_t &g = fccache_t::instance()->get_graph(*fc, tmp);
+
+  dominators_t doms;
+  if (!doms.build(g))
+  {
+    build_groupman_from_fc(fc, gm, sanitize);
+    return;
+  }
+  const domtree_t &dt = doms.get_domtree();
+
+  int node_count = g.size();
+
+  // Compute the node group of each node
+  intvec_t node_group;
+  node_group.resize(node_count, -1);
+
+  int_2dvec_t groups;
+  qstrvec_t sg_names;
+  if (use_sccs)
+  {
+    intvec_t comp;
+    int scc_count = compute_sccs(g, comp);
+
+    // Count the nodes in each component
+    intvec_t comp_size;
+    comp_size.resize(scc_count, 0);
+    for (int n=0; n < node_count; n++)
+      ++comp_size[comp[n]];
+
+    // Only the cyclic components are groupped
+    intvec_t comp_group;
+    comp_group.resize(scc_count, -1);
+    for (int n=0; n < node_count; n++)
+    {
+      int c = comp[n];
+      if (comp_size[c] == 1)
+      {
+        bool self_loop = false;
+        for (int i=0, nsucc=g.nsucc(n); i < nsucc && !self_loop; i++)
+          self_loop = g.succ(n, i) == n;
+        if (!self_loop)
+          continue;
+      }
+      if (comp_group[c] == -1)
+      {
+        comp_group[c] = int(groups.size());
+        groups.push_back();
+      }
+      node_group[n] = comp_group[c];
+      groups[comp_group[c]].push_back(n);
+    }
+
+    // The header is the component node that is reached first from the entry
+    for (size_t i=0; i < groups.size(); i++)
+    {
+      intvec_t &nodes = groups[i];
+      size_t ihead = 0;
+      for (size_t j=1; j < nodes.size(); j++)
+      {
+        int pj = dt.preorder_index(nodes[j]);
+        int ph = dt.preorder_index(nodes[ihead]);
+        if (pj != -1 && (ph == -1 || pj < ph))
+          ihead = j;
+      }
+      qswap(nodes[0], nodes[ihead]);
+      sg_names.push_back().sprnt("scc_%a", fc->blocks[nodes[0]].startEA);
+    }
+  }
+  else
+  {
+    loopforest_t lf;
+    lf.build(doms);
+
+    // Each outermost loop is collapsed
+    for (int l=0; l < lf.size(); l++)
+    {
+      if (lf[l].parent != -1)
+        continue;
+
+      int ng = int(groups.size());
+      intvec_t &nodes = groups.push_back();
+      lf.get_loop_nodes(l, nodes);
+      for (size_t i=0; i < nodes.size(); i++)
+        node_group[nodes[i]] = ng;
+
+      sg_names.push_back().sprnt("loop_%a", fc->blocks[lf[l].header].startEA);
+    }
+  }
+
+  // Build the path: the remaining nodes get their own super group
+  int_3dvec_t path;
+  qstrvec_t path_names;
+  boolvec_t emitted;
+  emitted.resize(groups.size(), false);
+  for (int n=0; n < node_count; n++)
+  {
+    int ng = node_group[n];
+    if (ng == -1)
+    {
+      path.push_back().push_back().push_back(n);
+      path_names.push_back();
+    }
+    else if (!emitted[ng])
+    {
+      emitted[ng] = true;
+      path.push_back().push_back(groups[ng]);
+      path_names.push_back(sg_names[ng]);
+    }
+  }
+
+  build_groupman_from_named_3dvec(fc, path, path_names, gm, sanitize);
+}
+
+//--------------------------------------------------------------------------
+void build_groupman_from_partition(
+  qflow_chart_t *fc,
+  int node_budget,
+  groupman_t *gm,
+  bool sanitize)
+{
+  int node_count = fc->size();
+  if (node_budget <= 0 || node_count <= node_budget)
+  {
+    build_groupman_from_fc(fc, gm, sanitize);
+    return;
+  }
+
+  fcgraph_t tmp;
+  const fcgraph_t &g = fccache_t::instance()->get_graph(*fc, tmp);
+
+  intvec_t part;
+  int nparts = partition_graph(g, node_budget, part);
+
+  // Each part is a super group with a single node group.
+  // Parts are numbered by their lowest node so the entry comes first
+  int_3dvec_t path;
+  path.resize(nparts);
+  for (int n=0; n < node_count; n++)
+  {
+    int_2dvec_t &sg = path[part[n]];
+    if (sg.empty())
+      sg.push_back();
+    sg[0].push_back(n);
+  }
+
+  qstrvec_t sg_names;
+  for (int i=0; i < nparts; i++)
+    sg_names.push_back().sprnt("cluster_%a", fc->blocks[path[i][0][0]].startEA);
+
+  build_groupman_from_named_3dvec(fc, path, sg_names, gm, sanitize);
+}
+
+//--------------------------------------------------------------------------
+size_t get_groupman_ng_count(groupman_t *gm)
+{
+  size_t count = 0;
+  psupergroup_listp_t sgl = gm->get_path_sgl();
+  for (supergroup_listp_t::iterator it=sgl->begin();
+       it != sgl->end();
+       ++it)
+  {
+    count += (*it)->gcount();
+  }
+  return count;
+}
+
 //--------------------------------------------------------------------------
 bool sanitize_groupman(
   ea_t func_ea,
@@ -24,6 +24,12 @@ History
 11/01/2013 - eliasb     - Now sanitize_groupman()' sanitized the path SGL only
                         - Added build_groupman_from_fc and build_groupman_from_3dvec functions
 04/10/2014 - eliasb     - fix: Auto increment SG number when building the info from BBMatch!Analyze()
+10/18/2026 - agent      - Added build_groupman_from_sese()
+                        - Added build_groupman_from_loops()
+                        - Added build_groupman_from_partition() and get_groupman_ng_count()
+                        - The CSR graphs come from the flowchart cache
+                        - Node texts come from the pooled function text (fctext_t)
+                        - Groupped nodes have no hint when the text is pooled: it is built on demand
 --------------------------------------------------------------------------*/
 
 
@@ -35,6 +41,11 @@ History
 #include <graph.hpp>
 #include "groupman.h"
 #include "util.h"
+#include "sesetree.h"
+#include "loops.h"
+#include "partition.h"
+#include "fccache.h"
+#include "fctext.h"
 
 //--------------------------------------------------------------------------
 /**
@@ -51,6 +62,16 @@ class fc_to_combined_mg
   qflow_chart_t *fc;
   bool show_nids_only;
 
+  /**
+  * @brief The disassembly text of the flowchart blocks
+  */
+  const fctext_t *ft;
+
+  /**
+  * @brief Can the nodes point to the text in 'ft'?
+  */
+  bool ref_text;
+
   /**
   * @brief Create and return a groupped node ID
   */
@@ -75,6 +96,12 @@ class fc_to_combined_mg
       gnode_t gn;
       gn.id = group_id;
       size_t t = loc->ng->size();
+
+      // A single node shows its block text as is: point to it
+      bool single_ref = ref_text && !show_nids_only && t == 1;
+
+      // The caller builds the hints of the groupped nodes on demand
+      bool lazy_hint = ref_text && t > 1;
       for (nodegroup_t::iterator it=loc->ng->begin();
            it != loc->ng->end();
            ++it)
@@ -86,13 +113,10 @@ class fc_to_combined_mg
             gn.text.append(", ");
         }
 
-        qbasic_block_t &block = fc->blocks[(*it)->nid];
-        qstring s;
-        get_disasm_text(
-          block.startEA, 
-          block.endEA, 
-          &s);
-        gn.hint.append(s);
+        if (single_ref)
+          gn.text_ref = ft->get_text((*it)->nid);
+        else if (!lazy_hint)
+          gn.hint.append(ft->get_text((*it)->nid));
       }
 
       if (!show_nids_only)
@@ -108,14 +132,14 @@ class fc_to_combined_mg
 
           gn.text.append("\n\n\n");
         }
-        else
+        else if (!single_ref)
         {
           gn.text = gn.hint;
         }
       }
 
       // Cache the node data
-      (*node_map)[group_id] = gn;
+      *node_map->add(group_id) = gn;
     }
     else
     {
@@ -201,7 +225,8 @@ public:
       gnodemap_t &node_map,
       ng2nid_t &group2id,
       mutable_graph_t *mg,
-      qflow_chart_t *fc = NULL): show_nids_only(false)
+      qflow_chart_t *fc = NULL,
+      const fctext_t *ft = NULL): show_nids_only(false)
   {
     // Build function's flowchart (if needed)
     qflow_chart_t _fc;
@@ -212,6 +237,17 @@ public:
         return;
     }
 
+    // Render the function's text at once (if needed)
+    // A temporary text cannot be referenced by the nodes
+    fctext_t _ft;
+    ref_text = ft != NULL;
+    if (ft == NULL)
+    {
+      _ft.build(*fc);
+      ft = &_ft;
+    }
+    this->ft = ft;
+
     build(fc, gm, node_map, group2id, mg);
   }
 };
@@ -219,13 +255,16 @@ public:
 //--------------------------------------------------------------------------
 /**
 * @brief Build a mutable graph from a function address
+* @param ft - the function's pooled text. The nodes point into it so it must
+*             outlive 'node_map'. When NULL, the text is copied into the nodes
 */
 bool func_to_mgraph(
     ea_t func_ea,
     mutable_graph_t *mg,
     gnodemap_t &node_map,
     qflow_chart_t *fc = NULL,
-    bool append_node_id = false);
+    bool append_node_id = false,
+    const fctext_t *ft = NULL);
 
 //--------------------------------------------------------------------------
 /**
@@ -246,6 +285,46 @@ void build_groupman_from_3dvec(
   groupman_t *gm,
   bool sanitize);
 
+//--------------------------------------------------------------------------
+/**
+* @brief Build the groupman from the single-entry/single-exit regions of the flowchart.
+*        Regions with at most 'max_region_size' nodes are collapsed into one node group
+*/
+void build_groupman_from_sese(
+  qflow_chart_t *fc,
+  int max_region_size,
+  groupman_t *gm,
+  bool sanitize);
+
+//--------------------------------------------------------------------------
+/**
+* @brief Build the groupman where each outermost natural loop (or each cyclic
+*        strongly connected component) is collapsed into one node group
+*        with its header as the first node
+*/
+void build_groupman_from_loops(
+  qflow_chart_t *fc,
+  bool use_sccs,
+  groupman_t *gm,
+  bool sanitize);
+
+//--------------------------------------------------------------------------
+/**
+* @brief Build the groupman from at most 'node_budget' balanced clusters of
+*        the flowchart. Each cluster is a super group with one node group
+*/
+void build_groupman_from_partition(
+  qflow_chart_t *fc,
+  int node_budget,
+  groupman_t *gm,
+  bool sanitize);
+
+//--------------------------------------------------------------------------
+/**
+* @brief Return the count of node groups in the path SGL: the node count of the combined graph
+*/
+size_t get_groupman_ng_count(groupman_t *gm);
+
 //--------------------------------------------------------------------------
 /**
 * @brief Sanitize the contents of the groupman path SGL versus the flowchart 
@@ -0,0 +1,336 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Basic block features module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+                                - The itype2 hash is a 64 bits multiset hash
+                                - Decode through insn_decoder_t and keep the operand codes
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "bbfeatures.h"
+#include <kernwin.hpp>
+
+//--------------------------------------------------------------------------
+// Prime numbers pool of bb_ida.py. Each instruction characteristic is a
+// product of primes: we keep the sorted prime indices instead
+static const int MAX_PRIMES = 8117;
+static const int OP_P_OFFS  = MAX_PRIMES - (UA_MAXOP * (o_last + 1));
+
+//--------------------------------------------------------------------------
+/**
+* @brief Return the prime numbers pool of bb_ida.py
+*/
+static const qvector<uint64> &get_primes()
+{
+  static qvector<uint64> primes;
+  for (int limit = 1 << 17; int(primes.size()) < MAX_PRIMES; limit *= 2)
+  {
+    primes.qclear();
+    boolvec_t composite(limit, false);
+    for (int n=2; n < limit && int(primes.size()) < MAX_PRIMES; n++)
+    {
+      if (composite[n])
+        continue;
+
+      primes.push_back(n);
+      for (int64 m=int64(n) * n; m < limit; m += n)
+        composite[int(m)] = true;
+    }
+  }
+  return primes;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Return the itype2 hash of each prime factor (_FactorHashes in bb_ida.py)
+*/
+static const uint64 *get_factor_hashes()
+{
+  static qvector<uint64> hashes;
+  if (hashes.empty())
+  {
+    hashes.resize(MAX_PRIMES);
+    for (int i=0; i < MAX_PRIMES; i++)
+      hashes[i] = mix64(uint64(i + 1));
+  }
+  return &hashes[0];
+}
+
+//--------------------------------------------------------------------------
+bool intvec_less_t::operator()(const intvec_t &a, const intvec_t &b) const
+{
+  return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+//--------------------------------------------------------------------------
+int intern_intvec(intvec_ids_t &ids, const intvec_t &key)
+{
+  intvec_ids_t::iterator it = ids.find(key);
+  if (it != ids.end())
+    return it->second;
+
+  int id = int(ids.size());
+  ids[key] = id;
+  return id;
+}
+
+//--------------------------------------------------------------------------
+bbfeatures_t::bbfeatures_t(): sketch_size(0)
+{
+}
+
+//--------------------------------------------------------------------------
+void bbfeatures_t::clear()
+{
+  itypes.qclear();
+  itype_slices.qclear();
+  freq_keys.qclear();
+  freq_counts.qclear();
+  freq_products.qclear();
+  freq_slices.qclear();
+  bytes.qclear();
+  bytes_slices.qclear();
+  icounts.qclear();
+  hashes1.qclear();
+  hashes2.qclear();
+  freq_sigs.qclear();
+  sketches.qclear();
+  itype1_ids.clear();
+  itype2_ids.clear();
+  char_ids.clear();
+  char_hashes.qclear();
+  char_products.qclear();
+  insn_nops.qclear();
+  op_codes.qclear();
+  op_slices.qclear();
+#ifdef MY_DEBUG
+  block_factors.clear();
+  itype2_factors.clear();
+#endif
+}
+
+//--------------------------------------------------------------------------
+size_t bbfeatures_t::memory_usage() const
+{
+  return sizeof(*this)
+       + itypes.size() * sizeof(uint16)
+       + insn_nops.size() + op_codes.size()
+       + (freq_keys.size() + freq_counts.size() + icounts.size() * 3) * sizeof(int)
+       + (freq_products.size() + freq_sigs.size() + sketches.size() + char_hashes.size() + char_products.size()) * sizeof(uint64)
+       + bytes.size()
+       + (itype_slices.size() + op_slices.size() + freq_slices.size() + bytes_slices.size()) * sizeof(slice_t);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Compute the itype1 hash and the frequency table of a block, like
+*        get_block_features() does
+*/
+void bbfeatures_t::add_block(insn_decoder_t *decoder, ea_t start, ea_t end)
+{
+  qstring itype_str;
+  std::map<int, int> freq;
+  const uint64 *factor_hashes = get_factor_hashes();
+
+#ifdef MY_DEBUG
+  block_factors.push_back();
+#endif
+
+  slice_t islice = { itypes.size(), 0 };
+  slice_t oslice = { op_codes.size(), 0 };
+  insn_desc_t insn;
+  intvec_t chr;
+  for (ea_t ea = start; ea < end && decoder->decode(ea, &insn); ea += insn.size)
+  {
+    itypes.push_back(insn.itype);
+    insn_nops.push_back(uchar(insn.nops));
+    op_codes.insert(op_codes.end(), insn.ops, insn.ops + insn.nops);
+    itype_str.cat_sprnt("%d", int(insn.itype));
+
+    // The prime indices of the instruction and of its operands
+    chr.qclear();
+    chr.push_back(insn.itype);
+    for (int i=0; i < insn.nops; i++)
+      chr.push_back(OP_P_OFFS + insn.ops[i]);
+    std::sort(chr.begin(), chr.end());
+
+#ifdef MY_DEBUG
+    block_factors.back().insert(block_factors.back().end(), chr.begin(), chr.end());
+#endif
+
+    // New characteristic: compute its hash and its product once
+    int char_id = intern_intvec(char_ids, chr);
+    if (char_id == int(char_hashes.size()))
+    {
+      const qvector<uint64> &prime_pool = get_primes();
+      uint64 h = 0, product = 1;
+      for (size_t i=0; i < chr.size(); i++)
+      {
+        h += factor_hashes[chr[i]];
+        product *= prime_pool[chr[i]];
+      }
+      char_hashes.push_back(h);
+      char_products.push_back(product);
+    }
+    ++freq[char_id];
+  }
+  oslice.len = op_codes.size() - oslice.off;
+  op_slices.push_back(oslice);
+  islice.len = itypes.size() - islice.off;
+  itype_slices.push_back(islice);
+  icounts.push_back(int(islice.len));
+
+  std::map<qstring, int>::iterator it = itype1_ids.find(itype_str);
+  if (it == itype1_ids.end())
+  {
+    hashes1.push_back(int(itype1_ids.size()));
+    itype1_ids[itype_str] = hashes1.back();
+  }
+  else
+  {
+    hashes1.push_back(it->second);
+  }
+
+  uint64 sig = 0;
+  slice_t fslice = { freq_keys.size(), freq.size() };
+  for (std::map<int, int>::iterator it_f = freq.begin(); it_f != freq.end(); ++it_f)
+  {
+    freq_keys.push_back(it_f->first);
+    freq_counts.push_back(it_f->second);
+    freq_products.push_back(char_products[it_f->first]);
+    sig |= uint64(1) << (it_f->first % 64);
+  }
+  freq_slices.push_back(fslice);
+  freq_sigs.push_back(sig);
+
+  slice_t bslice = { bytes.size(), 0 };
+  if (end > start)
+  {
+    bslice.len = size_t(end - start);
+    bytes.resize(bslice.off + bslice.len, 0);
+    decoder->get_bytes(start, &bytes[bslice.off], bslice.len);
+  }
+  bytes_slices.push_back(bslice);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief The itype2 hash of a block is the sum modulo 2^64 of the hashes of
+*        the prime factors of all its instructions, like hash_itype2() does.
+*        Blocks with the same characteristics product have the same hash
+*/
+void bbfeatures_t::hash_blocks()
+{
+  int count = size();
+  qvector<uint64> hashes(count, 0);
+  for (int n=0; n < count; n++)
+  {
+    const slice_t &fslice = freq_slices[n];
+    uint64 h = 0;
+    for (size_t i=fslice.off, end=fslice.off + fslice.len; i < end; i++)
+      h += uint64(freq_counts[i]) * char_hashes[freq_keys[i]];
+    hashes[n] = h;
+  }
+
+  hashes2.resize(count);
+  for (int n=0; n < count; n++)
+  {
+    std::map<uint64, int>::iterator it = itype2_ids.find(hashes[n]);
+    if (it == itype2_ids.end())
+    {
+      hashes2[n] = int(itype2_ids.size());
+      itype2_ids[hashes[n]] = hashes2[n];
+    }
+    else
+    {
+      hashes2[n] = it->second;
+    }
+
+#ifdef MY_DEBUG
+    intvec_t &factors = block_factors[n];
+    std::sort(factors.begin(), factors.end());
+    std::map<uint64, intvec_t>::iterator it_f = itype2_factors.find(hashes[n]);
+    if (it_f == itype2_factors.end())
+      itype2_factors[hashes[n]] = factors;
+    else if (it_f->second != factors)
+      msg("itype2 hash collision: %016" FMT_64 "X for block %d\n", hashes[n], n);
+#endif
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Compute the weighted MinHash sketch of a block like
+*        get_frequency_sketch() does: each characteristic counts as many
+*        times as it occurs
+*/
+void bbfeatures_t::compute_sketch(int n, uint64 *sketch) const
+{
+  const slice_t &fslice = freq_slices[n];
+  qvector<uint64> elems;
+  for (size_t i=fslice.off; i < fslice.off + fslice.len; i++)
+  {
+    uint64 base = mix64(freq_products[i]);
+    for (int j=0; j < freq_counts[i]; j++)
+      elems.push_back(mix64(base + j));
+  }
+
+  for (int i=0; i < sketch_size; i++)
+  {
+    uint64 seed = mix64(uint64(i + 1));
+    uint64 h = ~uint64(0);
+    for (size_t e=0; e < elems.size(); e++)
+    {
+      uint64 v = mix64(elems[e] ^ seed);
+      if (v < h)
+        h = v;
+    }
+    sketch[i] = h;
+  }
+}
+
+//--------------------------------------------------------------------------
+void bbfeatures_t::set_sketch_size(int entries)
+{
+  entries = qmax(entries, 0);
+  if (entries == sketch_size)
+    return;
+
+  sketch_size = entries;
+  sketches.resize(size_t(size()) * sketch_size);
+  for (int n=0, count=size(); n < count && sketch_size > 0; n++)
+    compute_sketch(n, &sketches[size_t(n) * sketch_size]);
+}
+
+//--------------------------------------------------------------------------
+void bbfeatures_t::build(
+    const qflow_chart_t &fc,
+    int sketch_entries,
+    insn_decoder_t *decoder)
+{
+  clear();
+  if (decoder == NULL)
+    decoder = ida_insn_decoder_t::instance();
+
+  int count = fc.size();
+  itype_slices.reserve(count);
+  freq_slices.reserve(count);
+  op_slices.reserve(count);
+  bytes_slices.reserve(count);
+  icounts.reserve(count);
+  hashes1.reserve(count);
+  freq_sigs.reserve(count);
+  for (int n=0; n < count; n++)
+    add_block(decoder, fc.blocks[n].startEA, fc.blocks[n].endEA);
+  hash_blocks();
+
+  // Compute the sketches of the new blocks
+  sketch_size = -1;
+  set_sketch_size(sketch_entries);
+}
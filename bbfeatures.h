@@ -0,0 +1,241 @@
+#ifndef __BBFEATURES__
+#define __BBFEATURES__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Basic block features module
+
+This module decodes each basic block of a function once and keeps what the
+matchers compare: the itype sequence, the operand codes, the instruction
+count, the characteristics frequency table, the itype1 and itype2 hashes, the
+frequency sketch and the bytes. The instructions are read through an
+insn_decoder_t. The features of all the blocks are pooled in
+contiguous arrays, each block gets a slice of them. This is the layout of the
+BlockFeatures store of bb_ida.py.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <map>
+#include <pro.h>
+#include <gdl.hpp>
+#include "types.hpp"
+#include "insndec.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Mix the bits of a 64 bits integer (splitmix64 finalizer, as _mix64()
+*        in bb_ida.py)
+*/
+inline uint64 mix64(uint64 x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Lexicographical order of integer vectors
+*/
+struct intvec_less_t
+{
+  bool operator()(const intvec_t &a, const intvec_t &b) const;
+};
+
+typedef std::map<intvec_t, int, intvec_less_t> intvec_ids_t;
+
+/**
+* @brief Return the id of an integer vector, the ids are given in the
+*        insertion order
+*/
+int intern_intvec(intvec_ids_t &ids, const intvec_t &key);
+
+//--------------------------------------------------------------------------
+/**
+* @brief Pooled features of the blocks of a function flowchart
+*/
+class bbfeatures_t
+{
+private:
+  struct slice_t
+  {
+    size_t off;
+    size_t len;
+  };
+  typedef qvector<slice_t> slice_vec_t;
+
+  /**
+  * @brief The itype sequences of all the blocks
+  */
+  qvector<uint16> itypes;
+  slice_vec_t itype_slices;
+
+  /**
+  * @brief The operand count of each instruction (parallel to 'itypes') and
+  *        the operand codes of all the blocks
+  */
+  qvector<uchar> insn_nops, op_codes;
+  slice_vec_t op_slices;
+
+  /**
+  * @brief The frequency tables: characteristic ids sorted in increasing
+  *        order, their counts and their prime products modulo 2^64
+  */
+  intvec_t freq_keys, freq_counts;
+  qvector<uint64> freq_products;
+  slice_vec_t freq_slices;
+
+  /**
+  * @brief The bytes of all the blocks
+  */
+  qvector<uchar> bytes;
+  slice_vec_t bytes_slices;
+
+  /**
+  * @brief Per block values
+  */
+  intvec_t icounts, hashes1, hashes2;
+  qvector<uint64> freq_sigs;
+
+  /**
+  * @brief The sketches of all the blocks, 'sketch_size' entries each
+  */
+  qvector<uint64> sketches;
+  int sketch_size;
+
+  /**
+  * @brief Interned hashes and characteristics
+  */
+  std::map<qstring, int> itype1_ids;
+  std::map<uint64, int> itype2_ids;
+  intvec_ids_t char_ids;
+
+  /**
+  * @brief The itype2 hash of each characteristic (the sum of the hashes of
+  *        its prime factors) and its prime product modulo 2^64
+  */
+  qvector<uint64> char_hashes, char_products;
+
+#ifdef MY_DEBUG
+  /**
+  * @brief The sorted prime factors of each block and of each itype2 hash,
+  *        to detect the hash collisions
+  */
+  int_2dvec_t block_factors;
+  std::map<uint64, intvec_t> itype2_factors;
+#endif
+
+  /**
+  * @brief Decode a block and append its features
+  */
+  void add_block(insn_decoder_t *decoder, ea_t start, ea_t end);
+
+  /**
+  * @brief Compute the itype2 hashes of all the blocks from their
+  *        frequency tables
+  */
+  void hash_blocks();
+
+  /**
+  * @brief Compute the sketch of a block
+  */
+  void compute_sketch(int n, uint64 *sketch) const;
+
+public:
+  bbfeatures_t();
+
+  /**
+  * @brief Decode all the blocks of a flowchart
+  * @param sketch_entries - entries of the frequency sketches
+  * @param decoder - the instructions decoder (NULL = IDA)
+  */
+  void build(
+      const qflow_chart_t &fc,
+      int sketch_entries,
+      insn_decoder_t *decoder = NULL);
+
+  /**
+  * @brief Recompute the sketches if their size changed
+  */
+  void set_sketch_size(int entries);
+
+  /**
+  * @brief Clear the features. The pools memory is kept for the next build
+  */
+  void clear();
+
+  inline int size() const { return int(icounts.size()); }
+
+  /**
+  * @brief Return the itype sequence of a block
+  */
+  inline const uint16 *get_itypes(int n) const { return &itypes[itype_slices[n].off]; }
+
+  /**
+  * @brief Return the operand count of each instruction of a block
+  */
+  inline const uchar *get_insn_nops(int n) const { return &insn_nops[itype_slices[n].off]; }
+
+  /**
+  * @brief Return the operand codes of all the instructions of a block
+  */
+  inline const uchar *get_op_codes(int n) const { return &op_codes[op_slices[n].off]; }
+  inline size_t get_op_codes_size(int n) const { return op_slices[n].len; }
+
+  /**
+  * @brief Return the instruction count of a block
+  */
+  inline int get_icount(int n) const { return icounts[n]; }
+
+  /**
+  * @brief Return the interned itype1 (instruction sequence) hash of a block
+  */
+  inline int get_hash1(int n) const { return hashes1[n]; }
+
+  /**
+  * @brief Return the interned itype2 (instruction and operand
+  *        characteristics) hash of a block
+  */
+  inline int get_hash2(int n) const { return hashes2[n]; }
+
+  /**
+  * @brief Count of the hashes given so far
+  */
+  inline int hash1_count() const { return int(itype1_ids.size()); }
+  inline int hash2_count() const { return int(itype2_ids.size()); }
+
+  /**
+  * @brief Return the frequency table of a block: get_freq_size() entries of
+  *        characteristic ids and counts
+  */
+  inline size_t get_freq_size(int n) const { return freq_slices[n].len; }
+  inline const int *get_freq_keys(int n) const { return &freq_keys[freq_slices[n].off]; }
+  inline const int *get_freq_counts(int n) const { return &freq_counts[freq_slices[n].off]; }
+
+  /**
+  * @brief One bit per characteristic id modulo 64. Blocks without a
+  *        common bit have no common characteristic
+  */
+  inline uint64 get_freq_sig(int n) const { return freq_sigs[n]; }
+
+  /**
+  * @brief Return the weighted MinHash sketch of the frequency table of a block
+  */
+  inline const uint64 *get_sketch(int n) const { return &sketches[size_t(n) * sketch_size]; }
+
+  /**
+  * @brief Return the bytes of a block
+  */
+  inline const uchar *get_bytes(int n) const { return &bytes[bytes_slices[n].off]; }
+  inline size_t get_bytes_size(int n) const { return bytes_slices[n].len; }
+
+  /**
+  * @brief Return the memory used in bytes
+  */
+  size_t memory_usage() const;
+};
+
+#endif
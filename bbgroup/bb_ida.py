@@ -21,6 +21,10 @@ This module contains IDA specific basic block datatypes and helper functions
                       - Made Rekeying optional and off by default (since it will mess up relative comparison)
 					  - Enforce division by floats where needed
 					  - Avoid division by zero
+10/18/2026 - agent  - match_block_frequencies() does not match empty blocks
+                    - Added get_frequency_sketch()
+                    - Added get_block_features() and the BlockFeatures store: blocks are decoded once
+                    - hash_itype2() is a 64 bits multiset hash of the characteristics prime factors
 
 TODO:
 ------
@@ -30,6 +34,9 @@ TODO:
 stdalone = False
 """Desginates whether this module is running inside IDA or in stand alone mode"""
 
+CHECK_ITYPE2_COLLISIONS = False
+"""Verify that blocks with the same hash_itype2() have the same characteristics"""
+
 # ------------------------------------------------------------------------------
 try:
     import idaapi
@@ -88,6 +95,45 @@ def get_cmd_prime_characteristics(cmd):
     return r * ro
 
 
+# ------------------------------------------------------------------------------
+def get_cmd_itype2_hash(cmd, factors=None):
+    """
+    Hash the prime factors of get_cmd_prime_characteristics().
+    Each factor has a fixed 64 bits hash. Sums of these hashes do not depend
+    on the order and are equal when the characteristics products are equal.
+    The prime indices of the factors are appended to 'factors' if given
+    """
+    i = cmd.itype
+    h = _FactorHashes[i]
+    if factors is not None:
+        factors.append(i)
+
+    for op in cmd.Operands:
+        if op.type == o_void:
+            break
+
+        i = _OP_P_OFFS + ((op.n * o_last) + op.type)
+        h += _FactorHashes[i]
+        if factors is not None:
+            factors.append(i)
+
+    return h
+
+
+# ------------------------------------------------------------------------------
+_Itype2Factors = {}
+
+def _format_itype2(h, factors):
+    """Format an itype2 hash. Check for collisions if needed"""
+    r = "%016x" % (h & _MASK64)
+    if factors is not None:
+        factors.sort()
+        old = _Itype2Factors.setdefault(r, factors)
+        if old != factors:
+            print "hash_itype2 collision: %s for %s and %s" % (r, old, factors)
+    return r
+
+
 # ------------------------------------------------------------------------------
 def hash_itype1(start, end):
     """Hash a block based on the instruction sequence"""
@@ -110,22 +156,22 @@ def hash_itype1(start, end):
 def hash_itype2(start, end):
     """
     Hash a block based on the instruction sequence.
-    Take into consideration the operands
+    Take into consideration the operands. Blocks with the same characteristics
+    product have the same hash, whatever the instructions order
     """
-    sh  = hashlib.sha1()
-    r = 1
+    factors = [] if CHECK_ITYPE2_COLLISIONS else None
+    h = 0
     while start < end:
         cmd = idautils.DecodeInstruction(start)
         if cmd is None:
             break
 
-        r = r * get_cmd_prime_characteristics(cmd)
+        h += get_cmd_itype2_hash(cmd, factors)
 
         # Advance decoder
         start += cmd.size
 
-    sh.update(str(r))
-    return sh.hexdigest()
+    return _format_itype2(h, factors)
 
 
 # ------------------------------------------------------------------------------
@@ -169,6 +215,76 @@ def get_block_frequency(start, end, rekey=False):
     return (t, d)
 
 
+# ------------------------------------------------------------------------------
+def get_block_features(start, end):
+    """
+    Decode a block once and compute all its features.
+    Returns a tuple containing the itype sequence, the frequency table as
+    returned by get_block_frequency(), hash_itype1() and hash_itype2()
+    """
+    itypes = []
+    d = {}
+    factors = [] if CHECK_ITYPE2_COLLISIONS else None
+    h = 0
+    while start < end:
+        cmd = idautils.DecodeInstruction(start)
+        if cmd is None:
+            break
+
+        itypes.append(cmd.itype)
+
+        c = get_cmd_prime_characteristics(cmd)
+        d[c] = d.get(c, 0) + 1
+        h += get_cmd_itype2_hash(cmd, factors)
+
+        # Advance decoder
+        start += cmd.size
+
+    sh = hashlib.sha1()
+    sh.update("".join([str(x) for x in itypes]))
+    h1 = sh.hexdigest()
+
+    return (itypes, (len(itypes), d), h1, _format_itype2(h, factors))
+
+
+# ------------------------------------------------------------------------------
+_MASK64 = (1 << 64) - 1
+
+def _mix64(x):
+    """Mix the bits of a 64 bits integer (splitmix64 finalizer)"""
+    x = ((x ^ (x >> 30)) * 0xBF58476D1CE4E5B9) & _MASK64
+    x = ((x ^ (x >> 27)) * 0x94D049BB133111EB) & _MASK64
+    return x ^ (x >> 31)
+
+
+# ------------------------------------------------------------------------------
+def get_frequency_sketch(ft, count):
+    """
+    Compute a weighted MinHash sketch of a frequency table.
+    Each characteristic counts as many times as it occurs, so two tables
+    agree on a sketch entry with a probability equal to their weighted
+    Jaccard similarity. The native matcher computes the same sketch.
+    """
+    t, d = ft
+
+    # One element per occurrence of a characteristic
+    elems = []
+    for k in d:
+        base = _mix64(k & _MASK64)
+        for j in range(d[k]):
+            elems.append(_mix64((base + j) & _MASK64))
+
+    sketch = []
+    for i in range(count):
+        seed = _mix64(i + 1)
+        if elems:
+            sketch.append(min([_mix64(e ^ seed) for e in elems]))
+        else:
+            sketch.append(_MASK64)
+
+    return sketch
+
+
 # ------------------------------------------------------------------------------
 def match_block_frequencies(ft1, ft2, p1, p2):
     """
@@ -181,6 +297,10 @@ def match_block_frequencies(ft1, ft2, p1, p2):
     t1, f1 = ft1
     t2, f2 = ft2
 
+    # Empty blocks have no frequencies
+    if t1 == 0 or t2 == 0:
+        return (False, False)
+
     # Identify big and small frequency tables
     if len(f1) > len(f2):
         fs = f2
@@ -233,6 +353,97 @@ def match_block_frequencies(ft1, ft2, p1, p2):
     return (ok1, ok2)
 
 
+# ------------------------------------------------------------------------------
+class BlockFeatures(object):
+    """
+    Features of the basic blocks of a function.
+    Each block is decoded once and its features are kept in parallel
+    arrays indexed by the block id (the native matcher uses the same layout)
+    """
+
+    def __init__(self):
+        self.clear()
+
+
+    def clear(self):
+        """Forget all the blocks"""
+        self.itypes = []
+        """The itype sequence of each block"""
+
+        self.inst_count = []
+        """Instruction count of each block (None if not computed)"""
+
+        self.freq = []
+        """Frequency table of each block as returned by get_block_frequency()"""
+
+        self.freq_sig = []
+        """One bit per characteristic modulo 64"""
+
+        self.hash_itype1 = []
+        self.hash_itype2 = []
+
+        self.bytes = []
+        """The bytes of each block (None if not requested)"""
+
+        self.sketches = []
+        """Frequency sketches, computed on demand"""
+
+
+    def __arrays(self):
+        return (self.itypes, self.inst_count, self.freq, self.freq_sig,
+                self.hash_itype1, self.hash_itype2, self.bytes, self.sketches)
+
+
+    def has(self, id):
+        """Were the features of a block computed?"""
+        return id < len(self.inst_count) and self.inst_count[id] is not None
+
+
+    def add(self, bb, get_bytes=True):
+        """Compute the features of a block if they are not known yet"""
+        id = bb.id
+        if self.has(id):
+            if get_bytes and self.bytes[id] is None:
+                self.bytes[id] = idaapi.get_many_bytes(bb.start, bb.end - bb.start)
+            return
+
+        # Grow all the arrays up to this block
+        grow = id + 1 - len(self.inst_count)
+        if grow > 0:
+            for a in self.__arrays():
+                a.extend([None] * grow)
+
+        itypes, ft, h1, h2 = get_block_features(bb.start, bb.end)
+
+        sig = 0
+        for k in ft[1]:
+            sig |= 1 << (k % 64)
+
+        self.itypes[id]      = itypes
+        self.inst_count[id]  = ft[0]
+        self.freq[id]        = ft
+        self.freq_sig[id]    = sig
+        self.hash_itype1[id] = h1
+        self.hash_itype2[id] = h2
+        if get_bytes:
+            self.bytes[id] = idaapi.get_many_bytes(bb.start, bb.end - bb.start)
+
+
+    def update(self, bm, get_bytes=False):
+        """Compute the features of the blocks of a manager that are not known yet"""
+        for bb in bm.items():
+            self.add(bb, get_bytes)
+
+
+    def get_sketch(self, id, count):
+        """Return the frequency sketch of a block with 'count' entries"""
+        sketch = self.sketches[id]
+        if sketch is None or len(sketch) != count:
+            sketch = get_frequency_sketch(self.freq[id], count)
+            self.sketches[id] = sketch
+        return sketch
+
+
 # ------------------------------------------------------------------------------
 class IdaBBContext(object):
     """IDA Basic block context class"""
@@ -258,23 +469,31 @@ class IdaBBContext(object):
             bytes=True, 
             itype1=True, 
             itype2=False,
-            icount=True):
-        """Compute the context of a basic block"""
+            icount=True,
+            features=None):
+        """
+        Compute the context of a basic block.
+        The block is decoded once and its features are kept in 'features'
+        """
+        if features is None:
+            features = BlockFeatures()
+        features.add(bb, bytes)
+
         # Get the bytes
         if bytes:
-            self.bytes = idaapi.get_many_bytes(bb.start, bb.end - bb.start)
+            self.bytes = features.bytes[bb.id]
 
         # Count instructions
         if icount:
-            self.inst_count = InstructionCount(bb.start, bb.end)
+            self.inst_count = features.inst_count[bb.id]
         
         # Get the itype1 hash
         if itype1:
-            self.hash_itype1 = hash_itype1(bb.start, bb.end)
+            self.hash_itype1 = features.hash_itype1[bb.id]
 
         # Get the itype2 hash
         if itype2:
-            self.hash_itype2 = hash_itype2(bb.start, bb.end)
+            self.hash_itype2 = features.hash_itype2[bb.id]
 
 
 # ------------------------------------------------------------------------------
@@ -282,6 +501,9 @@ class IDABBMan(BBMan):
     def __init__(self):
         BBMan.__init__(self)
 
+        self.features = BlockFeatures()
+        """Features of the blocks computed by this manager"""
+
     def add_bb_ctx(
             self, 
             bb, 
@@ -298,7 +520,8 @@ class IDABBMan(BBMan):
              bb, 
              get_bytes, 
              get_hash_itype1, 
-             get_hash_itype2)
+             get_hash_itype2,
+             features=self.features)
 
         # Assign context to the basic block object
         bb.ctx = ctx
@@ -436,6 +659,10 @@ _OP_P_OFFS    = _MAX_PRIMES - (UA_MAXOP * (o_last+1))
 # Precompute primes
 _CachedPrimes = bb_utils.CachedPrimes(_MAX_PRIMES)
 
+# The itype2 hash of each prime factor (by prime index). The native matcher
+# uses the same hashes
+_FactorHashes = [_mix64(i + 1) for i in xrange(_MAX_PRIMES)]
+
 # ------------------------------------------------------------------------------
 if __name__ == '__main__':
     ft1 = (7, {21614129: 5, 4790013691321L: 1, 722682555311L: 1})
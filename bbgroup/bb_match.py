@@ -10,6 +10,18 @@ It is written by Ali Rahbar and Ali Pezeshk
 11/07/2013 - eliasb   - Renamed some functions to work with the C adapter
 11/08/2013 - alipezes - Fixed serialization issue
 08/27/2014 - alirah   - Cleaned up the script and readied it for public release
+10/18/2026 - agent    - Walk the matches in insertion order so the native matcher can be compared with this one
+                      - Analyze() starts from a clean state
+                      - FindSimilar() returns node lists for a single node as well
+                      - The 'freq' hash does not depend on the set iteration order
+                      - hashBBMatch() buckets the exact hashes in one pass
+                      - The frequency tables are computed once per block and prefiltered by a signature
+                      - Fuzzy candidates come from MinHash sketches banded by LSH
+                      - The block features come from the BlockFeatures store of the graph
+                      - findSubGraphs() memoizes the successors matching and uses a plain list as queue
+                      - Matched paths are keyed by a Weisfeiler-Lehman subgraph fingerprint and deduplicated by sets
+                      - GetMatchedWellFormedFunctions() finds the covered paths with per node owner bitmaps
+                      - AddressIsInSubgraph() looks the block up in a sorted index of the block starts
 """
 
 import idaapi
@@ -19,9 +31,46 @@ import idaapi
 import pickle
 import cStringIO
 from   bb_ida import *
-import Queue
-from collections import defaultdict
+from bisect import bisect_right
+from collections import defaultdict, OrderedDict
 from ordered_set import OrderedSet
+from bb_ida import _mix64, _MASK64
+
+# ------------------------------------------------------------------------------
+# Seeds of the two 64 bits lanes of the subgraph fingerprints
+WL_SEEDS = (0x9E3779B97F4A7C15, 0xC2B2AE3D27D4EB4F)
+WL_SUCCS = 0x165667B19E3779F9
+WL_PREDS = 0x27D4EB2F165667C5
+
+def wlRefine(labels, succs, preds, seed):
+	"""One lane of the Weisfeiler-Lehman refinement: the color of a node is mixed with the sums of the
+	colors of its successors and predecessors until the partition of the nodes by color is stable"""
+	colors = [_mix64(l ^ seed) for l in labels]
+	classes = len(set(colors))
+	for r in xrange(len(colors)):
+		colors = [_mix64((colors[p]
+			+ _mix64((sum([colors[s] for s in succs[p]]) & _MASK64) ^ WL_SUCCS) * 3
+			+ _mix64((sum([colors[s] for s in preds[p]]) & _MASK64) ^ WL_PREDS) * 5) & _MASK64)
+			for p in xrange(len(colors))]
+		n = len(set(colors))
+		if n == classes:
+			break
+		classes = n
+	return colors
+
+def alignMatchedPaths(refColors, colors, path1, path2):
+	"""Reorder two matched paths so the node colors of the first one are refColors. The nodes of the same color keep their order"""
+	if len(refColors) != len(colors):
+		return path1, path2
+	positions = defaultdict(list)
+	for p in reversed(xrange(len(colors))):
+		positions[colors[p]].append(p)
+	order = []
+	for c in refColors:
+		if not positions[c]:
+			return path1, path2
+		order.append(positions[c].pop())
+	return [path1[p] for p in order], [path2[p] for p in order]
 
 # ------------------------------------------------------------------------------
 class bbMatcherClass:
@@ -34,21 +83,39 @@ class bbMatcherClass:
 	NodeHashMatchesMarker = "Node_Hash_Matches\n"
 	
 	def __init__(self,func_addr=None):
-		self.M={}
-		# this one contains paths matched, that have entries only to the head node
-		self.pathPerNodeHash=defaultdict(dict)
-		# this one contains paths matched, regardless of entries
-		self.pathPerNodeHashFull = defaultdict(dict)
-		self.normalizedPathPerNodeHash = {}
-		self.size_dic={}
-		self.sorted_keys=None
+		self.reset()
+		self.features = BlockFeatures()
+		# LSH of the frequency sketches: blocks are compared by frequency only when
+		# they agree on all the rows of a band. The similarity threshold is about
+		# (1/lshBands)^(1/lshRows). Set lshBands to 0 to compare all the blocks
+		self.lshBands = 16
+		self.lshRows = 2
 		self.G=None
 		self.address=None
-		self.nodeHashes = defaultdict(dict)
 		self.bm=None
 		if func_addr!=None:
 			self.buildGRaphFromFunc(func_addr)
 	
+	def reset(self):
+		"""Forget the previous analysis. The dictionaries keep the insertion order so results do not depend on the hash values"""
+		self.M=OrderedDict()
+		# this one contains paths matched, that have entries only to the head node
+		self.pathPerNodeHash=OrderedDict()
+		# this one contains paths matched, regardless of entries
+		self.pathPerNodeHashFull = OrderedDict()
+		self.normalizedPathPerNodeHash = OrderedDict()
+		self.size_dic={}
+		self.sorted_keys=None
+		self.nodeHashes = defaultdict(dict)
+		# (node, parent) -> matches of the node with each successor of the parent
+		self.succMatchMemo = {}
+		# ids of the node hashes and, by subgraph fingerprint, the node colors of the first path and the set of the paths
+		self.labelIds = {}
+		self.pathGroups = {}
+		self.pathGroupsFull = {}
+		# sorted block starts and their node ids, built on demand
+		self.blockIndex = None
+
 		
 	def buildGRaphFromFunc(self,func_addr):
 		"""Return a graph object from the function with the hash type 1"""
@@ -60,14 +127,67 @@ class bbMatcherClass:
 			get_hash_itype1 =True, 
 			get_hash_itype2 =True)
 		self.address = func_addr
+		self.blockIndex = None
+
+		# Blocks loaded from the cache were not decoded yet
+		self.features = self.bm.features
+		self.features.update(self.G)
+
+	def getBlockFrequency(self, N):
+		"""Return the frequency table of a node and a signature of its characteristics"""
+		t, d = self.features.freq[N.id]
+		return (t, d, self.features.freq_sig[N.id])
+
+	def getBlockSketch(self, N):
+		"""Return the MinHash sketch of the frequency table of a node"""
+		return self.features.get_sketch(N.id, self.lshBands * self.lshRows)
+
+	def lshCandidates(self, N1, N2):
+		"""Tell whether two nodes share an LSH band and should be compared by frequency"""
+		if self.lshBands <= 0:
+			return True
+		s1 = self.getBlockSketch(N1)
+		s2 = self.getBlockSketch(N2)
+		r = self.lshRows
+		for b in range(0, self.lshBands * r, r):
+			if s1[b:b + r] == s2[b:b + r]:
+				return True
+		return False
+
+	def lshCandidatePairs(self):
+		"""Return the sorted pairs of blocks sharing an LSH band"""
+		count = len(self.G.items())
+		if self.lshBands <= 0:
+			return [(i, j) for i in range(0, count) for j in range(i+1, count)]
+
+		pairs = set()
+		r = self.lshRows
+		for b in range(0, self.lshBands * r, r):
+			buckets = defaultdict(list)
+			for i in range(0, count):
+				buckets[tuple(self.getBlockSketch(self.G[i])[b:b + r])].append(i)
+			for members in buckets.values():
+				for z in range(0, len(members) - 1):
+					for j in members[z+1:]:
+						pairs.add((members[z], j))
+		return sorted(pairs)
 
 	def match(self,N1,N2, hashType):
 		"""Matches two nodes based on their type1(ordered instruction type hash) hash"""
 		if (hashType == 'freq'):
-			f1 = get_block_frequency(N1.start, N1.end)
-			f2 = get_block_frequency(N2.start, N2.end)
-			a, d1 = f1
-			b, d2 = f2
+			a, d1, sig1 = self.getBlockFrequency(N1)
+			b, d2, sig2 = self.getBlockFrequency(N2)
+
+			# Blocks without a common characteristic cannot match
+			if (sig1 & sig2) == 0:
+				return False
+
+			# Only the LSH candidates are checked
+			if not self.lshCandidates(N1, N2):
+				return False
+
+			f1 = (a, d1)
+			f2 = (b, d2)
 
 			if ( a <= 4 or b <= 4 ):
 				coveragePercentage = 50
@@ -82,7 +202,7 @@ class bbMatcherClass:
 			if (b1 and b2):
 				intersection = set.intersection(set(d1.keys()), set(d2.keys()))
 				freqHash = hashlib.sha1()
-				freqHash.update(intersection.__str__())
+				freqHash.update(str(sorted(intersection)))
 				hash = freqHash.hexdigest()
 				N1['freq'] = hash
 				N2['freq'] = hash
@@ -93,16 +213,38 @@ class bbMatcherClass:
 		
 	def hashBBMatch(self, hashType):
 		"""Creates a dictionary of basic blocks with the hash as the key and matching block numbers as items of a list for that entry"""
+		if hashType == 'freq':
+			self.fuzzyBBMatch(hashType)
+			return
+
+		# Exact hashes: group the blocks in one pass. Buckets are ordered by their first block
+		buckets = OrderedDict()
 		for i in range(0,len(self.G.items())):
-			for j in range (i+1,len(self.G.items())):
-				if self.match(self.G[i],self.G[j],hashType):
-					x=self.G[i][hashType] 
-					if self.M.has_key(x):
-						if self.M[x].count(j)==0:
-							self.M[x]+=[j]
-							
-					else:
-						self.M[x]=[i,j]
+			buckets.setdefault(self.G[i][hashType], []).append(i)
+
+		for x, members in buckets.items():
+			if len(members) < 2:
+				continue
+			if self.M.has_key(x):
+				known = set(self.M[x])
+				self.M[x] += [j for j in members if j not in known]
+			else:
+				self.M[x] = members
+
+	def fuzzyBBMatch(self, hashType):
+		"""Match the blocks pairwise for the hash types that are not an equivalence (the frequency tables)"""
+		members = {}
+		for i, j in self.lshCandidatePairs():
+			if self.match(self.G[i],self.G[j],hashType):
+				x=self.G[i][hashType] 
+				if self.M.has_key(x):
+					known = members.setdefault(x, set(self.M[x]))
+					if j not in known:
+						known.add(j)
+						self.M[x]+=[j]
+						
+				else:
+					self.M[x]=[i,j]
 
 	def makeSubgraphSingleEntryPoint(self,path1, path2):
 		if (len(path1) != len(path2)):
@@ -129,14 +271,36 @@ class bbMatcherClass:
 
 		return OrderedSet(tmp_path1), OrderedSet(tmp_path2)
 		
+	def succMatches(self, node1, Parent2):
+		"""Return the memo of the matches of node1 with the successors of Parent2: one dictionary per successor, from the hash type to the node hash (None = no match)"""
+		key = (node1, Parent2)
+		r = self.succMatchMemo.get(key)
+		if r is None:
+			r = [{} for m in self.G[Parent2].succs]
+			self.succMatchMemo[key] = r
+		return r
+
 	def findMatchInSuccs(self, node1, Parent2, hashType, visitedNodes2, tmpVisitedNodes2, path2):
 		matchedbyHash = False
-		for m in self.G[Parent2].succs:
+		m = None
+		memo = self.succMatches(node1, Parent2)
+		for i, m in enumerate(self.G[Parent2].succs):
 			if (m not in visitedNodes2) and (m !=Parent2) and (m not in path2):
 				tmpVisitedNodes2.add(m)
-				if (self.match(self.G[node1], self.G[m], hashType)):
+				try:
+					h = memo[i][hashType]
+				except KeyError:
+					h = None
+					if (self.match(self.G[node1], self.G[m], hashType)):
+						h = self.G[node1][hashType]
+					memo[i][hashType] = h
+				if h is not None:
 					if node1==m:
 						continue
+					# The frequency hash depends on the pair
+					if hashType == 'freq':
+						self.G[node1][hashType] = h
+						self.G[m][hashType] = h
 					matchedbyHash = True
 					break
 		return matchedbyHash, m, tmpVisitedNodes2
@@ -145,7 +309,7 @@ class bbMatcherClass:
 	def findSubGraphs(self):
 		"""Find equivalent path from two equivalent nodes
 		For each node hash it gets all of the BB and try to build path from each pair of them
-		The result is put in a dual dictionary that has the starting node hash as the first key, the path hash as the second key and the equivalent pathS as a list of sets(containing nodes) 
+		The result is put in a dual dictionary that has the starting node hash as the first key, the subgraph fingerprint as the second key and the equivalent pathS as a list of sets(containing nodes) 
 		"""
 		matchedPathsWithDifferentLengths = 0
 		for i in self.M.keys():
@@ -153,8 +317,8 @@ class bbMatcherClass:
 				for j in self.M[i][z+1:]:							#pick one from the second node onward
 					visited1=set()
 					visited2=set()
-					q1=Queue.Queue()					#add the first and n node to tmp
-					q1.put((self.M[i][z],j))
+					q1=[(self.M[i][z],j)]				#add the first and n node to tmp
+					qi=0
 					path1=OrderedSet()
 					path2=OrderedSet()
 					path1_bis=OrderedSet()
@@ -162,12 +326,10 @@ class bbMatcherClass:
 					path1NodeHashes = {}
 					path1.add(self.M[i][z])
 					path2.add(j)
-					path1Str=''
-					path2Str=''
 					path1NodeHashes[self.M[i][z]]=self.G[(self.M[i][z])].ctx.hash_itype2
-					pathHash1= hashlib.sha1()
-					while not q1.empty():			                            # for each matching pair from tmp
-						x,y = q1.get(block = False)
+					while qi < len(q1):			                            # for each matching pair from tmp
+						x,y = q1[qi]
+						qi += 1
 						tmp_visited2=set()
 						for l in self.G[x].succs :						
 							matchedbyHash = False
@@ -191,7 +353,7 @@ class bbMatcherClass:
 									path1NodeHashes[l] = self.G[l][hashType]
 									path1.add(l)
 									path2.add(m)
-									q1.put((l,m))
+									q1.append((l,m))
 									visited2.add(m)
 
 						visited2.update(tmp_visited2)
@@ -201,58 +363,46 @@ class bbMatcherClass:
 						path1_bis, path2_bis = self.makeSubgraphSingleEntryPoint(path1, path2) 
 				
 					if len(path1) >1:
-						for kk in path1:
-							path1Str+=path1NodeHashes[kk]
-							
-						pathHash1.update(path1Str)
-						a=pathHash1.hexdigest()
-						if not(self.pathPerNodeHashFull.has_key(i)) or (not( self.pathPerNodeHashFull[i].has_key(a))):
-							self.pathPerNodeHashFull[i][a]=[]
-
-						duplicate1 = False
-						duplicate2 = False
-					
-						listPath1 = list(path1)
-						listPath2 = list(path2)
-						
-						for zz in self.pathPerNodeHashFull[i][a]:
-							if listPath1 == zz:
-								duplicate1 = True
-							if listPath2 == zz:
-								duplicate2 = True
-								
-						if not duplicate1:
-							self.pathPerNodeHashFull[i][a].append(list(listPath1))
-						if not duplicate2:
-							self.pathPerNodeHashFull[i][a].append(list(listPath2))
+						self.addMatchedPaths(self.pathPerNodeHashFull, self.pathGroupsFull, i, list(path1), list(path2), path1NodeHashes)
 
 					if len(path1_bis) >1:
-						path1Str = ''
-						for kk in path1_bis:
-							path1Str+=path1NodeHashes[kk]
-							
-						pathHash1.update(path1Str)
-						a=pathHash1.hexdigest()
-						if not(self.pathPerNodeHash.has_key(i)) or (not( self.pathPerNodeHash[i].has_key(a))):
-							self.pathPerNodeHash[i][a]=[]
-
-						duplicate1 = False
-						duplicate2 = False
-					
-						listPath1 = list(path1_bis)
-						listPath2 = list(path2_bis)
-						
-						for zz in self.pathPerNodeHash[i][a]:
-							if listPath1 == zz:
-								duplicate1 = True
-							if listPath2 == zz:
-								duplicate2 = True
-								
-						if not duplicate1:
-							self.pathPerNodeHash[i][a].append(list(listPath1))
-						if not duplicate2:
-							self.pathPerNodeHash[i][a].append(list(listPath2))					
-		
+						self.addMatchedPaths(self.pathPerNodeHash, self.pathGroups, i, list(path1_bis), list(path2_bis), path1NodeHashes)
+
+	def subgraphFingerprint(self, path, nodeHashes):
+		"""Weisfeiler-Lehman fingerprint of the subgraph made of the path nodes and the edges between them.
+		The initial color of a node is its matched hash, the head is marked. Return the 128 bits fingerprint and the node colors"""
+		pos = dict((node, p) for p, node in enumerate(path))
+		succs = [[] for node in path]
+		preds = [[] for node in path]
+		for p, node in enumerate(path):
+			for s in self.G[node].succs:
+				if s in pos:
+					succs[p].append(pos[s])
+					preds[pos[s]].append(p)
+		labels = []
+		for p, node in enumerate(path):
+			labels.append(self.labelIds.setdefault(nodeHashes[node], len(self.labelIds)) * 2 + (p == 0))
+		fp = 0
+		colors = [0] * len(path)
+		for lane, seed in enumerate(WL_SEEDS):
+			c = wlRefine(labels, succs, preds, seed)
+			fp |= _mix64((sum(c) + len(c)) & _MASK64) << (64 * lane)
+			colors = [x | (y << (64 * lane)) for x, y in zip(colors, c)]
+		return fp, colors
+
+	def addMatchedPaths(self, groups, infos, head, path1, path2, nodeHashes):
+		"""Add two matched paths to the group of their subgraph fingerprint. They are ordered as the first paths of the group"""
+		fp, colors = self.subgraphFingerprint(path1, nodeHashes)
+		paths = groups.setdefault(head, OrderedDict()).setdefault(fp, [])
+		refColors, seen = infos.setdefault(fp, (colors, set()))
+		if colors != refColors:
+			path1, path2 = alignMatchedPaths(refColors, colors, path1, path2)
+		for path in (path1, path2):
+			key = tuple(path)
+			if key not in seen:
+				seen.add(key)
+				paths.append(path)
+
 	def sortByPathLen(self):
 		"""It gets the structure created by findSubGraph and creates a dictionary with the path len as the key and the tupple of node hash and path hash as the entry"""
 		
@@ -272,7 +422,9 @@ class bbMatcherClass:
 		return False
 		
 	def GetMatchedWellFormedFunctions(self, minFunctionSizeInBlocks = 4, minFunctionHeadSize = 0):
-		MovedSubgraph = []
+		# bit k of the owners of a node is set when the node is in the k-th moved subgraph
+		owners = defaultdict(int)
+		movedCount = 0
 		for i in reversed(sorted(self.size_dic.keys())):
 			if i < minFunctionSizeInBlocks :
 				break
@@ -280,19 +432,20 @@ class bbMatcherClass:
 			for item in self.size_dic[i]:
 				x,y=item
 				if (not self.normalizedPathPerNodeHash.has_key(x)):
-					self.normalizedPathPerNodeHash[x] = {}
+					self.normalizedPathPerNodeHash[x] = OrderedDict()
 				if (not self.normalizedPathPerNodeHash[x].has_key(y)):
 					self.normalizedPathPerNodeHash[x][y] = []
 
 				if self.subgraphHasExternalJumpsIntoIt( self.pathPerNodeHash[x][y][0]):
 					continue
 				for j in self.pathPerNodeHash[x][y]:
-					skip=False
-					for k in MovedSubgraph:
-						if set(j).issubset(set(k)):
-							skip=True
+					# skip the subgraphs that are in one of the moved ones
+					common = -1
+					for node in j:
+						common &= owners.get(node, 0)
+						if not common:
 							break
-					if not skip:
+					if not common:
 						self.normalizedPathPerNodeHash[x][y].append(j)
 
 				if len(self.normalizedPathPerNodeHash[x][y]) < 2 :
@@ -300,21 +453,34 @@ class bbMatcherClass:
 				else:
 					if ( minFunctionHeadSize > 0 ):
 						subgraphStartAddress = self.G[ self.normalizedPathPerNodeHash[x][y][0][0] ].start
+						subgraph = set(self.normalizedPathPerNodeHash[x][y][0])
 						functionHeadBigEnough = True
 						for address in range ( subgraphStartAddress, subgraphStartAddress + 8, 2 ):
-							if not AddressIsInSubgraph( address, self.normalizedPathPerNodeHash[x][y][0] ):
+							if not self.AddressIsInSubgraph( address, subgraph ):
 								functionHeadBigEnough = False
 								break
 						if not functionHeadBigEnough:
 							self.normalizedPathPerNodeHash[x][y] = [] 
 							
-				MovedSubgraph.extend( self.normalizedPathPerNodeHash[x][y] )
+				for j in self.normalizedPathPerNodeHash[x][y]:
+					for node in j:
+						owners[node] |= 1 << movedCount
+					movedCount += 1
+
+	def nodeAtAddress(self, address):
+		"""Return the id of the block holding an address or None"""
+		if self.blockIndex == None:
+			blocks = sorted([(self.G[n.id].start, n.id) for n in self.G.items()])
+			self.blockIndex = ([start for start, id in blocks], [id for start, id in blocks])
+		starts, ids = self.blockIndex
+		k = bisect_right(starts, address) - 1
+		if k >= 0 and address < self.G[ids[k]].end:
+			return ids[k]
+		return None
 
 	def AddressIsInSubgraph(self, address, subgraph) :
-		for i in subgraph :
-			if (self.G[i].start <= address < self.G[i].end) :
-				return True
-		return False
+		"""Tell whether an address is in one of the blocks of a subgraph. Pass a set for a constant time membership test"""
+		return self.nodeAtAddress(address) in subgraph
 	
 	def FindSimilar(self, nodeList, hashType = 'hash_itype2' ):
 		size = len(nodeList)
@@ -324,19 +490,20 @@ class bbMatcherClass:
 		result = []
 		
 		if ( size == 1 ):
-			return self.M[ self.nodeHashes[headNode][hashType] ]
+			return [[node] for node in self.M.get(self.nodeHashes[headNode][hashType], [])]
 		
 		for headNode in nodeList:
 			headNodeHash = self.nodeHashes[headNode][hashType]
-			for subgraphHash in self.pathPerNodeHashFull[headNodeHash]:
-				if size <= len(self.pathPerNodeHashFull[headNodeHash][subgraphHash][0]):
-					for match in self.pathPerNodeHashFull[headNodeHash][subgraphHash]:
+			subgraphs = self.pathPerNodeHashFull.get(headNodeHash, {})
+			for subgraphHash in subgraphs:
+				if size <= len(subgraphs[subgraphHash][0]):
+					for match in subgraphs[subgraphHash]:
 						if headNode == match[0] and setNodeList.issubset(set(match)):
 							# get the subsets from each path that matches the input node list
 							matchIndex = {}
 							for node in nodeList:
 								matchIndex[node] = match.index(node)
-							for matchedSubgraph in self.pathPerNodeHashFull[headNodeHash][subgraphHash]:
+							for matchedSubgraph in subgraphs[subgraphHash]:
 								subset = []
 								for node in nodeList:
 									subset.append( matchedSubgraph[matchIndex[node]] )
@@ -357,14 +524,11 @@ class bbMatcherClass:
 			reducedPathPerNodeHash[x] = {}
 			for y in self.normalizedPathPerNodeHash[x]:
 				reducedPathPerNodeHash[x][y] = []
-				for i in range(0, len(self.normalizedPathPerNodeHash[x][y])):
-					duplicate = False
-					for j in reducedPathPerNodeHash[x][y]:
-						if self.normalizedPathPerNodeHash[x][y][i].__str__() == j.__str__():
-							duplicate = True
-							break
-					if not duplicate:
-						reducedPathPerNodeHash[x][y].append( self.normalizedPathPerNodeHash[x][y][i] )
+				seen = set()
+				for path in self.normalizedPathPerNodeHash[x][y]:
+					if tuple(path) not in seen:
+						seen.add(tuple(path))
+						reducedPathPerNodeHash[x][y].append( path )
 
 
 		
@@ -377,7 +541,7 @@ class bbMatcherClass:
 			for y in reducedPathPerNodeHash[x]:
 				if reducedPathPerNodeHash[x][y] == []:
 					continue
-				f.write ("ID:%s;NODESET:"%(y)),
+				f.write ("ID:%032x;NODESET:"%(y)),
 				count =0
 				for i in reducedPathPerNodeHash[x][y]:
 					c += 1
@@ -461,6 +625,7 @@ class bbMatcherClass:
 	def Analyze(self,func_addr=None):
 		result = []
 		if func_addr!=None:
+			self.reset()
 			self.buildGRaphFromFunc(func_addr)
 		if self.G !=None:
 		# todo: refactor this to get the list from one place
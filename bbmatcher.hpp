@@ -0,0 +1,45 @@
+#ifndef __BBMATCHER_INC__
+#define __BBMATCHER_INC__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+BBMatcher interface
+
+The plugin talks to the basic block matchers through this interface. It is
+implemented by the Python matcher (bb_match.py) and by the native matcher.
+
+--------------------------------------------------------------------------*/
+
+#include <pro.h>
+#include "types.hpp"
+
+//--------------------------------------------------------------------------
+class BBMatcher
+{
+public:
+  virtual ~BBMatcher()
+  {
+  }
+
+  /**
+  * @brief Analyze and return the non-overlapping wellformed function instances
+  */
+  virtual void Analyze(ea_t func_addr, int_3dvec_t &result) = 0;
+
+  /**
+  * @brief Find the node lists similar to the given one in the last analyzed function
+  */
+  virtual bool FindSimilar(intvec_t &node_list, int_2dvec_t &similar) = 0;
+
+  /**
+  * @brief Set the LSH banding of the blocks frequency sketches. Blocks are
+  *        compared by frequency only when they agree on a band
+  * @param bands - count of bands (0 = compare all the blocks)
+  * @param rows - count of sketch entries per band
+  */
+  virtual void SetLSHParams(int bands, int rows) = 0;
+};
+
+#endif
@@ -12,22 +12,28 @@ History
 10/24/2013 - eliasb    - First version
 10/24/2013 - eliasb    - Added Rewind() method
 10/25/2013 - eliasb    - Added get_color_anyway() method
+10/18/2026 - agent     - HSL to RGB conversion uses integers only
+                       - Added the colorpalette_t class
+                       - Added the colorslots_t class
 
 --------------------------------------------------------------------------*/
 
+#include <stdlib.h>
 #include "colorgen.h"
 
 //----------------------------------------------------------------------
 // Conversion between the HSL(Hue, Saturation, and Luminosity)
 // and RBG color model.
 //----------------------------------------------------------------------
-// The conversion algorithms presented here come from the book by
-// Fundamentals of Interactive Computer Graphics by Foley and van Dam.
-// In the example code, HSL values are represented as floating point
-// number in the range 0 to 1. RGB tridrants use the Windows convention
-// of 0 to 255 of each element.
+// The conversion works with integers only: the hue is expressed in 1/256th
+// of the six color wheel sectors; saturation and luminosity go from 0 to 255.
+// RGB tridrants use the Windows convention of 0 to 255 of each element.
 //----------------------------------------------------------------------
 
+//--------------------------------------------------------------------------
+// Hue range of the integer conversion
+static const int HUE_RANGE = 6 * 256;
+
 //--------------------------------------------------------------------------
 /**
 * @brief 
@@ -48,33 +54,21 @@ inline unsigned int make_rgb(
   }
 }
 
-// ------------------------------------------------------------------------------
-/**
-* @brief 
-*/
-static unsigned char to_rgb(double rm1, double rm2, double rh) 
+//--------------------------------------------------------------------------
+inline unsigned char clamp_rgb(int v)
 {
-  if (rh > 360.0) 
-    rh -= 360.0;
-  else if (rh <   0.0) 
-    rh += 360.0;
-
-  if (rh <  60.0) 
-    rm1 = rm1 + (rm2 - rm1) * rh / 60.0;
-  else if (rh < 180.0) 
-    rm1 = rm2;
-  else if (rh < 240.0) 
-    rm1 = rm1 + (rm2 - rm1) * (240.0 - rh) / 60.0; 
-
-  return (unsigned char)(rm1 * 255.0);
+  return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v));
 }
 
 //--------------------------------------------------------------------------
-static unsigned int HSLtoRGB(
+/**
+* @brief Convert an HSL color. The hue is in the [0, HUE_RANGE) range
+*/
+static unsigned int HSLtoRGB_int(
   bool bRealRgb,
-  unsigned int H, 
-  unsigned int S, 
-  unsigned int L) 
+  int H,
+  int S,
+  int L)
 {
   if (S == 0)
   {
@@ -82,21 +76,42 @@ static unsigned int HSLtoRGB(
     return make_rgb(bRealRgb, L, L, L);
   }
 
-  double h = (double)H*360/255;
-  double s = (double)S / 255;
-  double l = (double)L / 255;
-  double rm1, rm2;
+  // Chroma, second largest component and lightness offset
+  int c = ((255 - abs(2 * L - 255)) * S) / 255;
+  int x = (c * (256 - abs(H % 512 - 256))) / 256;
+  int m = L - c / 2;
+
+  int r, g, b;
+  switch ((H / 256) % 6)
+  {
+    case 0:  r = c; g = x; b = 0; break;
+    case 1:  r = x; g = c; b = 0; break;
+    case 2:  r = 0; g = c; b = x; break;
+    case 3:  r = 0; g = x; b = c; break;
+    case 4:  r = x; g = 0; b = c; break;
+    default: r = c; g = 0; b = x; break;
+  }
 
-  if (l <= 0.5) 
-    rm2 = l + l * s;
-  else 
-    rm2 = l + s - l * s;
-  rm1 = 2.0 * l - rm2;
+  return make_rgb(
+    bRealRgb,
+    clamp_rgb(r + m),
+    clamp_rgb(g + m),
+    clamp_rgb(b + m));
+}
 
-  return make_rgb(bRealRgb, 
-             to_rgb(rm1, rm2, h + 120.0),
-             to_rgb(rm1, rm2, h),
-             to_rgb(rm1, rm2, h - 120.0) );
+//--------------------------------------------------------------------------
+static unsigned int HSLtoRGB(
+  bool bRealRgb,
+  unsigned int H, 
+  unsigned int S, 
+  unsigned int L) 
+{
+  // Scale the hue from [0, 255] to the integer conversion range
+  return HSLtoRGB_int(
+    bRealRgb,
+    int((H * HUE_RANGE) / 256) % HUE_RANGE,
+    int(S & 0xFF),
+    int(L & 0xFF));
 }
 
 //--------------------------------------------------------------------------
@@ -194,3 +209,87 @@ unsigned int colorgen_t::get_color_anyway(colorvargen_t &cv)
   }
   return clr;
 }
+
+//--------------------------------------------------------------------------
+// Palette parameters
+static const int PAL_HUE_STEP  = 949;   // ~0.618 of HUE_RANGE: consecutive colors are far apart
+static const int PAL_L_START   = 190;
+static const int PAL_L_INT     = 15;
+
+//--------------------------------------------------------------------------
+colorpalette_t::colorpalette_t(bool bRealRgb)
+{
+  for (int i=0; i < COLOR_COUNT; i++)
+  {
+    int h = (i * PAL_HUE_STEP) % HUE_RANGE;
+
+    // Alternate the saturation so close hues still differ
+    int s = 255 - (i % 3) * 50;
+    for (int shade=0; shade < SHADE_COUNT; shade++)
+      table[i][shade] = HSLtoRGB_int(bRealRgb, h, s, PAL_L_START - shade * PAL_L_INT);
+  }
+}
+
+//--------------------------------------------------------------------------
+const colorpalette_t &colorpalette_t::instance()
+{
+  static colorpalette_t palette;
+  return palette;
+}
+
+//--------------------------------------------------------------------------
+unsigned int colorpalette_t::hash_int(unsigned int v)
+{
+  // Finalizer of MurmurHash3
+  v ^= v >> 16;
+  v *= 0x85EBCA6B;
+  v ^= v >> 13;
+  v *= 0xC2B2AE35;
+  v ^= v >> 16;
+  return v;
+}
+
+//--------------------------------------------------------------------------
+unsigned int colorpalette_t::hash_str(const char *str)
+{
+  // FNV-1a
+  unsigned int h = 0x811C9DC5;
+  for (; *str != '\0'; ++str)
+  {
+    h ^= (unsigned char)*str;
+    h *= 0x01000193;
+  }
+  return hash_int(h);
+}
+
+//--------------------------------------------------------------------------
+colorslots_t::colorslots_t()
+{
+  clear();
+}
+
+//--------------------------------------------------------------------------
+void colorslots_t::clear()
+{
+  for (int i=0; i < colorpalette_t::COLOR_COUNT; i++)
+    used[i] = false;
+  used_count = 0;
+}
+
+//--------------------------------------------------------------------------
+unsigned int colorslots_t::get_key(unsigned int key)
+{
+  unsigned int slot = key % colorpalette_t::COLOR_COUNT;
+
+  // All the colors are given out: share the preferred one
+  if (used_count == colorpalette_t::COLOR_COUNT)
+    return slot;
+
+  // Probe for the next free color
+  while (used[slot])
+    slot = (slot + 1) % colorpalette_t::COLOR_COUNT;
+
+  used[slot] = true;
+  ++used_count;
+  return slot;
+}
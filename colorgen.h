@@ -45,3 +45,76 @@ public:
 
   void rewind();
 };
+
+//--------------------------------------------------------------------------
+/**
+* @brief Precomputed palette of distinct colors. Each color comes in a few shades.
+*        Colors are picked from a key (usually a hash) so they do not depend
+*        on the order in which they are requested
+*/
+class colorpalette_t
+{
+public:
+  enum
+  {
+    COLOR_COUNT = 64,
+    SHADE_COUNT = 6,
+  };
+
+private:
+  unsigned int table[COLOR_COUNT][SHADE_COUNT];
+
+public:
+  colorpalette_t(bool bRealRgb = false);
+
+  /**
+  * @brief Return the shared palette (IDA's BGR colors)
+  */
+  static const colorpalette_t &instance();
+
+  /**
+  * @brief Return the color of a key in the given shade
+  */
+  inline unsigned int get_color(unsigned int key, unsigned int shade = 0) const
+  {
+    return table[key % COLOR_COUNT][shade % SHADE_COUNT];
+  }
+
+  /**
+  * @brief Hash a string into a palette key
+  */
+  static unsigned int hash_str(const char *str);
+
+  /**
+  * @brief Hash an integer into a palette key
+  */
+  static unsigned int hash_int(unsigned int v);
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Palette colors given out during one highlighting pass. A key gets
+*        the color it hashes to, or the next free one, so the colors of a
+*        pass stay distinct while there are enough of them. The keys should
+*        be given in a fixed order (e.g. sorted) for the colors to only
+*        depend on the set of keys
+*/
+class colorslots_t
+{
+private:
+  bool used[colorpalette_t::COLOR_COUNT];
+  int used_count;
+
+public:
+  colorslots_t();
+
+  /**
+  * @brief Forget the given out colors
+  */
+  void clear();
+
+  /**
+  * @brief Return the palette key of the color given to a key
+  */
+  unsigned int get_key(unsigned int key);
+};
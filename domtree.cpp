@@ -0,0 +1,356 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Dominators module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "domtree.h"
+
+//--------------------------------------------------------------------------
+//--  DOMINATOR TREE CLASS  ------------------------------------------------
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+void domtree_t::clear()
+{
+  root_node = -1;
+  idoms.qclear();
+  preorder.qclear();
+  preorder_idx.qclear();
+  subtree_end.qclear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Walk up the (partial) dominator tree until both fingers meet
+*/
+static int intersect_doms(
+    int a,
+    int b,
+    const intvec_t &idoms,
+    const intvec_t &po_num)
+{
+  while (a != b)
+  {
+    while (po_num[a] < po_num[b])
+      a = idoms[a];
+    while (po_num[b] < po_num[a])
+      b = idoms[b];
+  }
+  return a;
+}
+
+//--------------------------------------------------------------------------
+bool domtree_t::build(const fcgraph_t &g, int root)
+{
+  clear();
+
+  int node_count = g.size();
+  if (root < 0 || root >= node_count)
+    return false;
+
+  root_node = root;
+  idoms.resize(node_count, -1);
+  preorder_idx.resize(node_count, -1);
+  subtree_end.resize(node_count, -1);
+
+  //
+  // Compute the postorder of the reachable nodes with an iterative DFS
+  //
+  intvec_t po_num;
+  po_num.resize(node_count, -1);
+  intvec_t postorder;
+  {
+    boolvec_t visited;
+    visited.resize(node_count, false);
+    intvec_t stk_node, stk_edge;
+
+    visited[root] = true;
+    stk_node.push_back(root);
+    stk_edge.push_back(0);
+    while (!stk_node.empty())
+    {
+      int n = stk_node.back();
+      int &e = stk_edge.back();
+      if (e < g.nsucc(n))
+      {
+        int s = g.succ(n, e++);
+        if (!visited[s])
+        {
+          visited[s] = true;
+          stk_node.push_back(s);
+          stk_edge.push_back(0);
+        }
+        continue;
+      }
+      po_num[n] = int(postorder.size());
+      postorder.push_back(n);
+      stk_node.pop_back();
+      stk_edge.pop_back();
+    }
+  }
+
+  //
+  // Iterate in reverse postorder until the immediate dominators are stable
+  //
+  idoms[root] = root;
+  for (bool changed = true; changed; )
+  {
+    changed = false;
+    for (int i=int(postorder.size()) - 2; i >= 0; i--)
+    {
+      int n = postorder[i];
+      int new_idom = -1;
+      for (int ipred=0, npred=g.npred(n); ipred < npred; ipred++)
+      {
+        int p = g.pred(n, ipred);
+
+        // Skip unprocessed or unreachable predecessors
+        if (idoms[p] == -1)
+          continue;
+
+        new_idom = new_idom == -1 ? p : intersect_doms(p, new_idom, idoms, po_num);
+      }
+      if (idoms[n] != new_idom)
+      {
+        idoms[n] = new_idom;
+        changed = true;
+      }
+    }
+  }
+  idoms[root] = -1;
+
+  //
+  // Number the dominator tree in preorder so dominance checks are interval checks
+  //
+  intvec_t tsrc, tdst;
+  for (int n=0; n < node_count; n++)
+  {
+    if (idoms[n] == -1)
+      continue;
+    tsrc.push_back(idoms[n]);
+    tdst.push_back(n);
+  }
+  fcgraph_t tree;
+  tree.build(node_count, tsrc, tdst);
+
+  preorder.reserve(postorder.size());
+
+  intvec_t stk_node, stk_edge;
+  preorder_idx[root] = 0;
+  preorder.push_back(root);
+  stk_node.push_back(root);
+  stk_edge.push_back(0);
+  while (!stk_node.empty())
+  {
+    int n = stk_node.back();
+    int &e = stk_edge.back();
+    if (e < tree.nsucc(n))
+    {
+      int c = tree.succ(n, e++);
+      preorder_idx[c] = int(preorder.size());
+      preorder.push_back(c);
+      stk_node.push_back(c);
+      stk_edge.push_back(0);
+      continue;
+    }
+    subtree_end[n] = int(preorder.size());
+    stk_node.pop_back();
+    stk_edge.pop_back();
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+int nodemarks_t::new_mark(int count)
+{
+  if (int(marks.size()) < count)
+  {
+    marks.resize(count, 0);
+    slots.resize(count, -1);
+  }
+
+  if (++gen < 0)
+  {
+    // Wrapped around, reset all the marks
+    for (size_t i=0; i < marks.size(); i++)
+      marks[i] = 0;
+    gen = 1;
+  }
+  return gen;
+}
+
+//--------------------------------------------------------------------------
+//--  DOMINATORS CLASS  ----------------------------------------------------
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+bool dominators_t::build(const fcgraph_t &g, int entry)
+{
+  this->g = &g;
+
+  if (!dt.build(g, entry))
+    return false;
+
+  // Post-dominators are the dominators of the reversed graph rooted at the virtual exit
+  rg.build_reverse_with_exit(g);
+  if (!pdt.build(rg, exit_node()))
+    return false;
+
+  return true;
+}
+
+
+//--------------------------------------------------------------------------
+void dominators_t::get_region(
+    int entry,
+    int exit,
+    intvec_t &nodes)
+{
+  nodes.qclear();
+  if (!dt.is_reachable(entry))
+    return;
+
+  // The region is the dominator subtree of the entry minus the exit's subtree
+  int skip_node = exit == exit_node() || !dt.dominates(entry, exit) ? -1 : exit;
+  for (int i=dt.preorder_index(entry), end=dt.preorder_end(entry); i < end; i++)
+  {
+    int n = dt.preorder_node(i);
+    if (n == skip_node)
+    {
+      i = dt.preorder_end(n) - 1;
+      continue;
+    }
+    nodes.push_back(n);
+  }
+}
+
+//--------------------------------------------------------------------------
+bool dominators_t::is_single_entry(
+    const intvec_t &nodes,
+    int head,
+    nodemarks_t &nm) const
+{
+  intvec_t &marks = nm.marks;
+  int m = nm.new_mark(g->size());
+  for (size_t i=0; i < nodes.size(); i++)
+    marks[nodes[i]] = m;
+
+  for (size_t i=0; i < nodes.size(); i++)
+  {
+    int n = nodes[i];
+    if (n == head)
+      continue;
+
+    for (int ipred=0, npred=g->npred(n); ipred < npred; ipred++)
+    {
+      if (marks[g->pred(n, ipred)] != m)
+        return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+int dominators_t::single_entry_core(
+    const intvec_t &nodes,
+    int head,
+    boolvec_t &keep,
+    nodemarks_t &nm) const
+{
+  intvec_t &marks = nm.marks, &slots = nm.slots;
+  int m = nm.new_mark(g->size());
+  size_t count = nodes.size();
+
+  // Remember each node's position in the input set
+  for (size_t i=0; i < count; i++)
+  {
+    marks[nodes[i]] = m;
+    slots[nodes[i]] = int(i);
+  }
+
+  // Seed the work list with the nodes that have outside predecessors
+  keep.qclear();
+  keep.resize(count, true);
+
+  intvec_t worklist;
+  for (size_t i=0; i < count; i++)
+  {
+    int n = nodes[i];
+    if (n == head)
+      continue;
+
+    for (int ipred=0, npred=g->npred(n); ipred < npred; ipred++)
+    {
+      if (marks[g->pred(n, ipred)] != m)
+      {
+        keep[i] = false;
+        worklist.push_back(n);
+        break;
+      }
+    }
+  }
+
+  // Removing a node turns it into an outside predecessor of its successors
+  int kept = int(count - worklist.size());
+  while (!worklist.empty())
+  {
+    int n = worklist.back();
+    worklist.pop_back();
+
+    for (int isucc=0, nsucc=g->nsucc(n); isucc < nsucc; isucc++)
+    {
+      int s = g->succ(n, isucc);
+      if (s == head || marks[s] != m || !keep[slots[s]])
+        continue;
+
+      keep[slots[s]] = false;
+      --kept;
+      worklist.push_back(s);
+    }
+  }
+  return kept;
+}
+
+//--------------------------------------------------------------------------
+int dominators_t::single_entry_prefix(
+    const intvec_t &nodes,
+    nodemarks_t &nm) const
+{
+  int count = int(nodes.size());
+  if (count == 0)
+    return 0;
+
+  intvec_t &marks = nm.marks, &slots = nm.slots;
+  int m = nm.new_mark(g->size());
+  for (int i=0; i < count; i++)
+  {
+    marks[nodes[i]] = m;
+    slots[nodes[i]] = i;
+  }
+
+  // A prefix of length 'k' is valid when all the predecessors of its nodes
+  // (minus the head) have a position below 'k'
+  int best = 1;
+  int max_need = 0;
+  for (int k=2; k <= count; k++)
+  {
+    int n = nodes[k - 1];
+    for (int ipred=0, npred=g->npred(n); ipred < npred; ipred++)
+    {
+      int p = g->pred(n, ipred);
+      int need = marks[p] == m ? slots[p] : count;
+      if (need > max_need)
+        max_need = need;
+    }
+    if (max_need < k)
+      best = k;
+  }
+  return best;
+}
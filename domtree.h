@@ -0,0 +1,264 @@
+#ifndef __DOMTREE__
+#define __DOMTREE__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Dominators module
+
+This module computes the dominator and post-dominator trees of a flowchart
+and answers single-entry and single-entry/single-exit (SESE) region queries.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include "fcgraph.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief A dominator tree computed over the predecessors of a graph
+*/
+class domtree_t
+{
+private:
+  int root_node;
+
+  /**
+  * @brief Immediate dominator of each node (-1 for the root and unreachable nodes)
+  */
+  intvec_t idoms;
+
+  /**
+  * @brief Dominator tree preorder: the node at each position and the position of each node
+  */
+  intvec_t preorder, preorder_idx;
+
+  /**
+  * @brief Exclusive end (in preorder) of each node's subtree
+  */
+  intvec_t subtree_end;
+
+public:
+  domtree_t(): root_node(-1) { }
+
+  /**
+  * @brief Compute the dominator tree of 'g' rooted at 'root'
+  *        (Cooper, Harvey and Kennedy iterative algorithm)
+  */
+  bool build(const fcgraph_t &g, int root);
+
+  /**
+  * @brief Clear the tree
+  */
+  void clear();
+
+  inline int root() const { return root_node; }
+  inline int size() const { return int(idoms.size()); }
+
+  /**
+  * @brief Return the immediate dominator of a node or -1
+  */
+  inline int idom(int n) const { return idoms[n]; }
+
+  /**
+  * @brief Is the node reachable from the root?
+  */
+  inline bool is_reachable(int n) const { return preorder_idx[n] != -1; }
+
+  /**
+  * @brief Does 'a' dominate 'b'? A node dominates itself. O(1)
+  */
+  inline bool dominates(int a, int b) const
+  {
+    int pa = preorder_idx[a], pb = preorder_idx[b];
+    return pa != -1 && pb != -1 && pa <= pb && pb < subtree_end[a];
+  }
+
+  /**
+  * @brief Return the reachable nodes count
+  */
+  inline int preorder_count() const { return int(preorder.size()); }
+
+  /**
+  * @brief Return the node at the given preorder position
+  */
+  inline int preorder_node(int i) const { return preorder[i]; }
+
+  /**
+  * @brief Return the preorder position of a node or -1 if it is not reachable
+  */
+  inline int preorder_index(int n) const { return preorder_idx[n]; }
+
+  /**
+  * @brief Return the exclusive preorder end of the subtree rooted at 'n'
+  */
+  inline int preorder_end(int n) const { return subtree_end[n]; }
+
+  /**
+  * @brief Return the count of nodes dominated by 'n' (including 'n')
+  */
+  inline int subtree_size(int n) const
+  {
+    return preorder_idx[n] == -1 ? 0 : subtree_end[n] - preorder_idx[n];
+  }
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Scratch marks and positions of the node set queries. They are only
+*        valid for the nodes carrying the current mark. Queries running
+*        concurrently on the same dominators_t need one each
+*/
+struct nodemarks_t
+{
+  intvec_t marks, slots;
+  int gen;
+
+  nodemarks_t(): gen(0) { }
+
+  /**
+  * @brief Start a new query on a graph of 'count' nodes and return its marker
+  */
+  int new_mark(int count);
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Dominators and post-dominators of a function flowchart
+*/
+class dominators_t
+{
+private:
+  const fcgraph_t *g;
+
+  /**
+  * @brief Reverse graph with a virtual exit node used for the post-dominators
+  */
+  fcgraph_t rg;
+
+  domtree_t dt, pdt;
+
+  /**
+  * @brief Scratch of the node set queries that do not bring their own
+  */
+  nodemarks_t own_marks;
+
+public:
+  dominators_t(): g(NULL) { }
+
+  /**
+  * @brief Compute the dominators and post-dominators of a graph.
+  *        The graph must stay alive as long as this object is used
+  */
+  bool build(const fcgraph_t &g, int entry = 0);
+
+  /**
+  * @brief Return the graph
+  */
+  inline const fcgraph_t *graph() const { return g; }
+
+  /**
+  * @brief Return the id of the virtual exit node used in the post-dominator tree
+  */
+  inline int exit_node() const { return g->size(); }
+
+  inline const domtree_t &get_domtree() const { return dt; }
+  inline const domtree_t &get_postdomtree() const { return pdt; }
+
+  /**
+  * @brief Return the immediate dominator of a node or -1
+  */
+  inline int idom(int n) const { return dt.idom(n); }
+
+  /**
+  * @brief Return the immediate post-dominator of a node, exit_node() or -1
+  */
+  inline int ipdom(int n) const { return pdt.idom(n); }
+
+  /**
+  * @brief Does 'a' dominate 'b'? O(1)
+  */
+  inline bool dominates(int a, int b) const { return dt.dominates(a, b); }
+
+  /**
+  * @brief Does 'a' post-dominate 'b'? O(1)
+  */
+  inline bool postdominates(int a, int b) const { return pdt.dominates(a, b); }
+
+  /**
+  * @brief Is (entry, exit) a SESE pair: entry dominates exit and exit post-dominates entry? O(1)
+  *        'exit' may be exit_node() for regions that extend to the function's end
+  */
+  inline bool is_sese(int entry, int exit) const
+  {
+    return (exit == exit_node() || dt.dominates(entry, exit))
+         && pdt.dominates(exit, entry);
+  }
+
+  /**
+  * @brief Is the node in the region delimited by the SESE pair (entry, exit)?
+  *        The exit node does not belong to the region. O(1)
+  */
+  inline bool in_region(int n, int entry, int exit) const
+  {
+    return dt.dominates(entry, n)
+        && (exit == exit_node() || !dt.dominates(exit, n));
+  }
+
+  /**
+  * @brief Collect the nodes of the region delimited by (entry, exit)
+  */
+  void get_region(int entry, int exit, intvec_t &nodes);
+
+  /**
+  * @brief Checks that the only edges coming into the node set target 'head'.
+  *        This is bbMatcherClass.subgraphHasExternalJumpsIntoIt() negated.
+  *        O(nodes + their predecessors)
+  */
+  bool is_single_entry(
+    const intvec_t &nodes,
+    int head,
+    nodemarks_t &nm) const;
+
+  inline bool is_single_entry(const intvec_t &nodes, int head)
+  {
+    return is_single_entry(nodes, head, own_marks);
+  }
+
+  /**
+  * @brief Compute the biggest subset of 'nodes' containing 'head' that can only
+  *        be entered through 'head'. 'keep' receives a flag per input node
+  * @return Count of kept nodes
+  */
+  int single_entry_core(
+    const intvec_t &nodes,
+    int head,
+    boolvec_t &keep,
+    nodemarks_t &nm) const;
+
+  inline int single_entry_core(
+    const intvec_t &nodes,
+    int head,
+    boolvec_t &keep)
+  {
+    return single_entry_core(nodes, head, keep, own_marks);
+  }
+
+  /**
+  * @brief Return the length of the longest prefix of 'nodes' that can only
+  *        be entered through its first node. This is the semantic used by
+  *        bbMatcherClass.makeSubgraphSingleEntryPoint()
+  */
+  int single_entry_prefix(
+    const intvec_t &nodes,
+    nodemarks_t &nm) const;
+
+  inline int single_entry_prefix(const intvec_t &nodes)
+  {
+    return single_entry_prefix(nodes, own_marks);
+  }
+};
+
+#endif
@@ -0,0 +1,363 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Flowchart cache module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+                                - Compare the successors and predecessors of the blocks
+                                - Hand out the cached flowcharts without copying them
+                                - Code reference changes invalidate the flowchart
+--------------------------------------------------------------------------*/
+
+#include "fccache.h"
+#include <idp.hpp>
+#include <kernwin.hpp>
+
+//--------------------------------------------------------------------------
+// Default bounds
+static const size_t DEF_MAX_ENTRIES = 16;
+static const size_t DEF_MAX_BYTES = 64 * 1024 * 1024;
+
+//--------------------------------------------------------------------------
+fccache_t::fccache_t()
+{
+  max_entries = DEF_MAX_ENTRIES;
+  max_bytes = DEF_MAX_BYTES;
+  used_bytes = 0;
+  change_counter = 0;
+  hooked = false;
+}
+
+//--------------------------------------------------------------------------
+fccache_t::~fccache_t()
+{
+  // The hooks are removed by the plugin on termination
+  entries.clear();
+  lookup.clear();
+}
+
+//--------------------------------------------------------------------------
+fccache_t *fccache_t::instance()
+{
+  static fccache_t cache;
+  return &cache;
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::hook()
+{
+  if (hooked)
+    return;
+
+  hook_to_notification_point(HT_IDB, idb_callback, this);
+  hook_to_notification_point(HT_IDP, idp_callback, this);
+  hooked = true;
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::unhook()
+{
+  if (hooked)
+  {
+    unhook_from_notification_point(HT_IDB, idb_callback, this);
+    unhook_from_notification_point(HT_IDP, idp_callback, this);
+    hooked = false;
+  }
+  invalidate_all();
+}
+
+//--------------------------------------------------------------------------
+int idaapi fccache_t::idb_callback(
+    void *ud,
+    int notification_code,
+    va_list va)
+{
+  fccache_t *self = (fccache_t *)ud;
+  switch (notification_code)
+  {
+    case idb_event::byte_patched:
+    {
+      ea_t ea = va_arg(va, ea_t);
+      self->invalidate_func_at(ea);
+      break;
+    }
+    case idb_event::func_tail_appended:
+    case idb_event::func_tail_removed:
+    {
+      func_t *pfn = va_arg(va, func_t *);
+      self->invalidate(pfn->startEA);
+      break;
+    }
+    case idb_event::tail_owner_changed:
+    {
+      // Both the old and the new owner are affected
+      self->invalidate_all();
+      break;
+    }
+  }
+  return 0;
+}
+
+//--------------------------------------------------------------------------
+int idaapi fccache_t::idp_callback(
+    void *ud,
+    int notification_code,
+    va_list va)
+{
+  fccache_t *self = (fccache_t *)ud;
+  switch (notification_code)
+  {
+    case processor_t::add_func:
+    case processor_t::del_func:
+    case processor_t::set_func_start:
+    case processor_t::set_func_end:
+    {
+      func_t *pfn = va_arg(va, func_t *);
+      self->invalidate(pfn->startEA);
+      break;
+    }
+    case processor_t::make_code:
+    case processor_t::undefine:
+    {
+      ea_t ea = va_arg(va, ea_t);
+      self->invalidate_func_at(ea);
+      break;
+    }
+    // A code reference changes the edges of the flowchart of its source
+    case processor_t::add_cref:
+    case processor_t::del_cref:
+    {
+      ea_t from = va_arg(va, ea_t);
+      self->invalidate_func_at(from);
+      break;
+    }
+  }
+  // Let the processor module handle the event
+  return 0;
+}
+
+//--------------------------------------------------------------------------
+size_t fccache_t::fc_memory_usage(const qflow_chart_t &fc)
+{
+  size_t mem = sizeof(fc) + fc.title.length();
+  for (size_t i=0; i < fc.blocks.size(); i++)
+  {
+    const qbasic_block_t &block = fc.blocks[i];
+    mem += sizeof(block) + (block.succ.size() + block.pred.size()) * sizeof(int);
+  }
+  return mem;
+}
+
+//--------------------------------------------------------------------------
+fccache_t::entry_t *fccache_t::find(ea_t func_ea)
+{
+  entry_map_t::iterator it = lookup.find(func_ea);
+  if (it == lookup.end())
+    return NULL;
+
+  // Move to the front
+  entries.splice(entries.begin(), entries, it->second);
+  return &entries.front();
+}
+
+//--------------------------------------------------------------------------
+fccache_t::entry_t *fccache_t::find(const qflow_chart_t &fc)
+{
+  entry_map_t::iterator it = lookup.find(fc.bounds.startEA);
+  if (it == lookup.end())
+    return NULL;
+
+  // The caller may hold a flowchart older than the cached one: compare the blocks
+  // and their edges
+  const qflow_chart_t &cfc = it->second->fc;
+  if (cfc.size() != fc.size() || cfc.nproper != fc.nproper)
+    return NULL;
+
+  for (int n=0, nodes_count=fc.size(); n < nodes_count; n++)
+  {
+    const qbasic_block_t &b1 = fc.blocks[n];
+    const qbasic_block_t &b2 = cfc.blocks[n];
+    if (    b1.startEA != b2.startEA
+         || b1.endEA != b2.endEA
+         || b1.succ != b2.succ
+         || b1.pred != b2.pred)
+    {
+      return NULL;
+    }
+  }
+  return find(fc.bounds.startEA);
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::erase(entry_map_t::iterator it)
+{
+  used_bytes -= it->second->mem;
+  entries.erase(it->second);
+  lookup.erase(it);
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::trim()
+{
+  // The most recent entry always stays even if it alone exceeds the bounds
+  while (    entries.size() > 1
+          && (    (max_entries != 0 && entries.size() > max_entries)
+               || (max_bytes != 0 && used_bytes > max_bytes)))
+  {
+    erase(lookup.find(entries.back().func_ea));
+    ++stats.evictions;
+  }
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::set_limits(
+    size_t max_entries,
+    size_t max_bytes)
+{
+  this->max_entries = max_entries;
+  this->max_bytes = max_bytes;
+  trim();
+}
+
+//--------------------------------------------------------------------------
+const qflow_chart_t *fccache_t::get_flowchart(ea_t ea)
+{
+  func_t *f = get_func(ea);
+  if (f == NULL)
+    return NULL;
+
+  hook();
+
+  entry_t *e = find(f->startEA);
+  if (e != NULL)
+  {
+    ++stats.hits;
+    return &e->fc;
+  }
+  ++stats.misses;
+
+  entries.push_front(entry_t());
+  e = &entries.front();
+  e->func_ea = f->startEA;
+  e->has_graph = false;
+
+  qstring s;
+  s.sprnt("$ flowchart of %a()", f->startEA);
+  e->fc.create(
+    s.c_str(),
+    f,
+    BADADDR,
+    BADADDR,
+    FC_PREDS);
+
+  e->mem = fc_memory_usage(e->fc);
+  used_bytes += e->mem;
+  lookup[e->func_ea] = entries.begin();
+
+  // The entry is the most recent one: trimming never drops it
+  trim();
+
+  return &e->fc;
+}
+
+//--------------------------------------------------------------------------
+bool fccache_t::get_flowchart(
+    ea_t ea,
+    qflow_chart_t &qf)
+{
+  const qflow_chart_t *fc = get_flowchart(ea);
+  if (fc == NULL)
+    return false;
+
+  qf = *fc;
+  return true;
+}
+
+//--------------------------------------------------------------------------
+const fcgraph_t &fccache_t::get_graph(
+    const qflow_chart_t &fc,
+    fcgraph_t &tmp)
+{
+  entry_t *e = find(fc);
+  if (e == NULL)
+  {
+    ++stats.graph_misses;
+    tmp.build(fc);
+    return tmp;
+  }
+
+  if (e->has_graph)
+  {
+    ++stats.graph_hits;
+  }
+  else
+  {
+    ++stats.graph_misses;
+    e->g.build(e->fc);
+    e->has_graph = true;
+
+    size_t mem = e->g.memory_usage();
+    e->mem += mem;
+    used_bytes += mem;
+
+    // The entry is the most recent one: trimming never drops it
+    trim();
+  }
+  return e->g;
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::invalidate_func_at(ea_t ea)
+{
+  if (lookup.empty())
+    return;
+
+  func_t *f = get_func(ea);
+  if (f != NULL)
+    invalidate(f->startEA);
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::invalidate(ea_t func_ea)
+{
+  entry_map_t::iterator it = lookup.find(func_ea);
+  if (it == lookup.end())
+    return;
+
+  erase(it);
+  ++stats.invalidations;
+  ++change_counter;
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::invalidate_all()
+{
+  if (entries.empty())
+    return;
+
+  stats.invalidations += uint32(entries.size());
+  entries.clear();
+  lookup.clear();
+  used_bytes = 0;
+  ++change_counter;
+}
+
+//--------------------------------------------------------------------------
+void fccache_t::dump_stats(const char *prefix) const
+{
+  msg("%sflowchart cache: %u entries, %u KB, %u hits, %u misses, "
+      "graph %u hits, %u misses, %u evictions, %u invalidations\n",
+      prefix,
+      uint32(entries.size()),
+      uint32(used_bytes / 1024),
+      stats.hits,
+      stats.misses,
+      stats.graph_hits,
+      stats.graph_misses,
+      stats.evictions,
+      stats.invalidations);
+}
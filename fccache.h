@@ -0,0 +1,184 @@
+#ifndef __FCCACHE__
+#define __FCCACHE__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Flowchart cache module
+
+This module keeps the most recently used function flowcharts and their
+CSR graphs so re-opening or re-analyzing a function does not rebuild them.
+Entries are dropped when the database notifies a change in their function.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <list>
+#include <map>
+#include <pro.h>
+#include <funcs.hpp>
+#include <gdl.hpp>
+#include "fcgraph.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Cache statistics
+*/
+struct fccache_stats_t
+{
+  uint32 hits;
+  uint32 misses;
+  uint32 graph_hits;
+  uint32 graph_misses;
+  uint32 evictions;
+  uint32 invalidations;
+
+  fccache_stats_t()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    hits = misses = graph_hits = graph_misses = evictions = invalidations = 0;
+  }
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief LRU cache of function flowcharts keyed by the function start address
+*/
+class fccache_t
+{
+private:
+  struct entry_t
+  {
+    ea_t func_ea;
+    qflow_chart_t fc;
+
+    /**
+    * @brief CSR snapshot of 'fc', built on first use
+    */
+    fcgraph_t g;
+    bool has_graph;
+
+    /**
+    * @brief Estimated memory used by the entry in bytes
+    */
+    size_t mem;
+  };
+  typedef std::list<entry_t> entry_list_t;
+  typedef std::map<ea_t, entry_list_t::iterator> entry_map_t;
+
+  /**
+  * @brief Entries, the most recently used first
+  */
+  entry_list_t entries;
+  entry_map_t lookup;
+
+  size_t max_entries;
+  size_t max_bytes;
+  size_t used_bytes;
+
+  /**
+  * @brief Incremented each time cached entries are invalidated
+  */
+  uint32 change_counter;
+
+  bool hooked;
+  fccache_stats_t stats;
+
+  static int idaapi idb_callback(void *ud, int notification_code, va_list va);
+  static int idaapi idp_callback(void *ud, int notification_code, va_list va);
+
+  /**
+  * @brief Return the cached entry of a function and make it the most recent one
+  */
+  entry_t *find(ea_t func_ea);
+
+  /**
+  * @brief Return the cached entry matching a flowchart built by the caller
+  */
+  entry_t *find(const qflow_chart_t &fc);
+
+  void erase(entry_map_t::iterator it);
+
+  /**
+  * @brief Evict the least recently used entries until the limits are honored
+  */
+  void trim();
+
+  static size_t fc_memory_usage(const qflow_chart_t &fc);
+
+  /**
+  * @brief Invalidate the function holding the given address
+  */
+  void invalidate_func_at(ea_t ea);
+
+public:
+  fccache_t();
+  ~fccache_t();
+
+  /**
+  * @brief Return the global cache instance
+  */
+  static fccache_t *instance();
+
+  /**
+  * @brief Install the database change notifications
+  */
+  void hook();
+
+  /**
+  * @brief Remove the notifications and drop all entries
+  */
+  void unhook();
+
+  /**
+  * @brief Set the memory bounds. A zero value means no limit
+  */
+  void set_limits(size_t max_entries, size_t max_bytes);
+
+  /**
+  * @brief Return the flowchart of the function holding 'ea' or NULL.
+  *        The flowchart is built and cached if needed. It is valid until
+  *        the next call to the cache or the next database change
+  */
+  const qflow_chart_t *get_flowchart(ea_t ea);
+
+  /**
+  * @brief Copy the flowchart of the function holding 'ea' into 'qf', for
+  *        callers that keep it
+  */
+  bool get_flowchart(ea_t ea, qflow_chart_t &qf);
+
+  /**
+  * @brief Return the CSR graph of a flowchart.
+  *        The cached snapshot is returned if it matches 'fc' otherwise the graph
+  *        is built in 'tmp'
+  */
+  const fcgraph_t &get_graph(const qflow_chart_t &fc, fcgraph_t &tmp);
+
+  /**
+  * @brief Drop the cached entry of a function
+  */
+  void invalidate(ea_t func_ea);
+
+  /**
+  * @brief Drop all the cached entries
+  */
+  void invalidate_all();
+
+  inline uint32 get_change_counter() const { return change_counter; }
+  inline const fccache_stats_t &get_stats() const { return stats; }
+  inline size_t size() const { return entries.size(); }
+  inline size_t memory_usage() const { return used_bytes; }
+
+  /**
+  * @brief Print the cache statistics to the output window
+  */
+  void dump_stats(const char *prefix) const;
+};
+
+#endif
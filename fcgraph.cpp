@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Flowchart graph module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "fcgraph.h"
+
+//--------------------------------------------------------------------------
+void fcgraph_t::clear()
+{
+  succ_start.qclear();
+  pred_start.qclear();
+  succ_list.qclear();
+  pred_list.qclear();
+}
+
+//--------------------------------------------------------------------------
+void fcgraph_t::build(
+    int node_count,
+    const intvec_t &src,
+    const intvec_t &dst)
+{
+  clear();
+
+  // Count the out/in degree of each node (shifted by one)
+  succ_start.resize(node_count + 1, 0);
+  pred_start.resize(node_count + 1, 0);
+
+  size_t nedges = src.size();
+  for (size_t i=0; i < nedges; i++)
+  {
+    ++succ_start[src[i] + 1];
+    ++pred_start[dst[i] + 1];
+  }
+
+  // Turn the degrees into offsets
+  for (int n=0; n < node_count; n++)
+  {
+    succ_start[n + 1] += succ_start[n];
+    pred_start[n + 1] += pred_start[n];
+  }
+
+  // Scatter the edges. The edges order per node is preserved
+  succ_list.resize(nedges);
+  pred_list.resize(nedges);
+
+  intvec_t succ_pos(succ_start), pred_pos(pred_start);
+  for (size_t i=0; i < nedges; i++)
+  {
+    int s = src[i], d = dst[i];
+    succ_list[succ_pos[s]++] = d;
+    pred_list[pred_pos[d]++] = s;
+  }
+}
+
+//--------------------------------------------------------------------------
+void fcgraph_t::build(const qflow_chart_t &fc)
+{
+  intvec_t src, dst;
+
+  int node_count = fc.size();
+  for (int n=0; n < node_count; n++)
+  {
+    for (int i=0, nsucc=fc.nsucc(n); i < nsucc; i++)
+    {
+      src.push_back(n);
+      dst.push_back(fc.succ(n, i));
+    }
+  }
+  build(node_count, src, dst);
+}
+
+//--------------------------------------------------------------------------
+void fcgraph_t::build_reverse_with_exit(const fcgraph_t &g)
+{
+  intvec_t src, dst;
+
+  int node_count = g.size();
+  int exit_node = node_count;
+  for (int n=0; n < node_count; n++)
+  {
+    int nsucc = g.nsucc(n);
+
+    // Link the virtual exit to the function's exit blocks
+    if (nsucc == 0)
+    {
+      src.push_back(exit_node);
+      dst.push_back(n);
+      continue;
+    }
+
+    for (int i=0; i < nsucc; i++)
+    {
+      src.push_back(g.succ(n, i));
+      dst.push_back(n);
+    }
+  }
+  build(node_count + 1, src, dst);
+}
+
+//--------------------------------------------------------------------------
+size_t fcgraph_t::memory_usage() const
+{
+  return sizeof(*this)
+       + (succ_start.size() + pred_start.size() + succ_list.size() + pred_list.size()) * sizeof(int);
+}
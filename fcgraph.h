@@ -0,0 +1,87 @@
+#ifndef __FCGRAPH__
+#define __FCGRAPH__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Flowchart graph module
+
+This module defines a compact adjacency representation (CSR) of a function
+flowchart. The native graph algorithms work on it instead of walking the
+qflow_chart_t structures.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include <gdl.hpp>
+
+//--------------------------------------------------------------------------
+/**
+* @brief Compressed sparse row graph with successor and predecessor lists
+*/
+class fcgraph_t
+{
+private:
+  /**
+  * @brief Offsets into the succ/pred lists. They have (node_count + 1) entries
+  */
+  intvec_t succ_start, pred_start;
+
+  /**
+  * @brief The concatenated successors and predecessors of all the nodes
+  */
+  intvec_t succ_list, pred_list;
+
+public:
+  /**
+  * @brief Return the nodes count
+  */
+  inline int size() const
+  {
+    return succ_start.empty() ? 0 : int(succ_start.size()) - 1;
+  }
+
+  /**
+  * @brief Return the edges count
+  */
+  inline int edge_count() const { return int(succ_list.size()); }
+
+  inline int nsucc(int n) const { return succ_start[n+1] - succ_start[n]; }
+  inline int succ(int n, int i) const { return succ_list[succ_start[n] + i]; }
+  inline int npred(int n) const { return pred_start[n+1] - pred_start[n]; }
+  inline int pred(int n, int i) const { return pred_list[pred_start[n] + i]; }
+
+  /**
+  * @brief Clear the graph
+  */
+  void clear();
+
+  /**
+  * @brief Build the graph from an edge list (src[i] -> dst[i])
+  */
+  void build(
+    int node_count,
+    const intvec_t &src,
+    const intvec_t &dst);
+
+  /**
+  * @brief Build the graph from a function flowchart
+  */
+  void build(const qflow_chart_t &fc);
+
+  /**
+  * @brief Build the reverse of a graph with an additional virtual exit node.
+  *        The virtual exit (node id g.size()) is linked to every node that has
+  *        no successors in 'g'
+  */
+  void build_reverse_with_exit(const fcgraph_t &g);
+
+  /**
+  * @brief Return the memory used by the graph in bytes
+  */
+  size_t memory_usage() const;
+};
+
+#endif
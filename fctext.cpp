@@ -0,0 +1,130 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Function text module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "fctext.h"
+#include <kernwin.hpp>
+#include <lines.hpp>
+
+//--------------------------------------------------------------------------
+/**
+* @brief Sort the block ids by address
+*/
+struct block_ea_less_t
+{
+  const qflow_chart_t *fc;
+
+  block_ea_less_t(const qflow_chart_t *fc): fc(fc)
+  {
+  }
+
+  bool operator()(int n1, int n2) const
+  {
+    return fc->blocks[n1].startEA < fc->blocks[n2].startEA;
+  }
+};
+
+//--------------------------------------------------------------------------
+void fctext_t::clear()
+{
+  pool.qclear();
+  slices.qclear();
+
+  // Empty slices point to this terminator
+  pool.push_back('\0');
+}
+
+//--------------------------------------------------------------------------
+size_t fctext_t::memory_usage() const
+{
+  return sizeof(*this) + pool.size() + slices.size() * sizeof(slice_t);
+}
+
+//--------------------------------------------------------------------------
+void fctext_t::add_line(const char *line)
+{
+  pool.insert(pool.end(), line, line + qstrlen(line));
+  pool.push_back('\n');
+}
+
+//--------------------------------------------------------------------------
+void fctext_t::end_block(int n, size_t start)
+{
+  slice_t &slice = slices[n];
+  slice.off = start;
+  slice.len = pool.size() - start;
+  pool.push_back('\0');
+}
+
+//--------------------------------------------------------------------------
+void fctext_t::build(const qflow_chart_t &fc)
+{
+  clear();
+
+  int nodes_count = fc.size();
+  slice_t empty = { 0, 0 };
+  slices.resize(nodes_count, empty);
+
+  // Visit the blocks by address so adjacent blocks form a single run
+  intvec_t order;
+  order.reserve(nodes_count);
+  for (int n=0; n < nodes_count; n++)
+  {
+    const qbasic_block_t &block = fc.blocks[n];
+    if (block.startEA < block.endEA)
+      order.push_back(n);
+  }
+  std::sort(order.begin(), order.end(), block_ea_less_t(&fc));
+
+  text_t txt;
+  for (size_t first=0, count=order.size(); first < count; )
+  {
+    // Find the end of the run
+    size_t last = first;
+    while (    last + 1 < count
+            && fc.blocks[order[last]].endEA == fc.blocks[order[last + 1]].startEA)
+    {
+      ++last;
+    }
+
+    txt.qclear();
+    gen_disasm_text(
+      fc.blocks[order[first]].startEA,
+      fc.blocks[order[last]].endEA,
+      txt,
+      false);
+
+    // Distribute the lines to the blocks of the run
+    size_t cur = first;
+    size_t start = pool.size();
+    for (text_t::iterator it=txt.begin(); it != txt.end(); ++it)
+    {
+      ea_t ea = it->at == NULL ? BADADDR : it->at->toea();
+      while (    cur < last
+              && ea != BADADDR
+              && ea >= fc.blocks[order[cur]].endEA)
+      {
+        end_block(order[cur++], start);
+        start = pool.size();
+      }
+      add_line(it->line);
+    }
+
+    // Close the remaining blocks of the run
+    for (; cur <= last; cur++)
+    {
+      end_block(order[cur], start);
+      start = pool.size();
+    }
+    first = last + 1;
+  }
+}
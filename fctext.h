@@ -0,0 +1,84 @@
+#ifndef __FCTEXT__
+#define __FCTEXT__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Function text module
+
+This module renders the disassembly of a whole function at once into a
+single buffer. Each basic block gets a slice of that buffer so node texts
+can point into it instead of owning a copy.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include <gdl.hpp>
+
+//--------------------------------------------------------------------------
+/**
+* @brief Pooled disassembly text of a function flowchart
+*/
+class fctext_t
+{
+private:
+  struct slice_t
+  {
+    size_t off;
+    size_t len;
+  };
+  typedef qvector<slice_t> slice_vec_t;
+
+  /**
+  * @brief The text of all the blocks. Each block text is zero terminated
+  */
+  qvector<char> pool;
+
+  /**
+  * @brief The text location of each block
+  */
+  slice_vec_t slices;
+
+  /**
+  * @brief Append a line to the pool
+  */
+  void add_line(const char *line);
+
+  /**
+  * @brief Terminate the text of the given block
+  */
+  void end_block(int n, size_t start);
+
+public:
+  /**
+  * @brief Render the disassembly of all the blocks of a flowchart.
+  *        Adjacent blocks are rendered with a single disassembly call
+  */
+  void build(const qflow_chart_t &fc);
+
+  /**
+  * @brief Clear the text. The pool memory is kept for the next build
+  */
+  void clear();
+
+  inline int size() const { return int(slices.size()); }
+
+  /**
+  * @brief Return the zero terminated text of a block. It stays valid until the next build
+  */
+  inline const char *get_text(int n) const { return &pool[slices[n].off]; }
+
+  /**
+  * @brief Return the text length of a block
+  */
+  inline size_t get_length(int n) const { return slices[n].len; }
+
+  /**
+  * @brief Return the memory used in bytes
+  */
+  size_t memory_usage() const;
+};
+
+#endif
@@ -28,6 +28,7 @@ History
 11/06/2013 - eliasb             - added 'remove_sg', 'move_nodes_to_ng'
                                 - added 'reset_groupping'
                                 - added added nodegroup_list_t.add_nodegroup()
+10/18/2026 - agent              - added groupman_listener_t to notify the groupping changes
 --------------------------------------------------------------------------*/
 
 #define USE_STANDARD_FILE_FUNCTIONS
@@ -261,6 +262,7 @@ void groupman_t::clear()
   clear_sgl(&path_sgl);
   clear_sgl(&similar_sgl);
   all_nodes.clear();
+  notify_groups_reset();
 }
 
 //--------------------------------------------------------------------------
@@ -423,6 +425,7 @@ psupergroup_t groupman_t::add_supergroup(
     sg = new supergroup_t();
 
   sgl->push_back(sg);
+  notify_sg_changed(sg);
   return sg;
 }
 
@@ -432,6 +435,7 @@ void groupman_t::remove_supergroup(
       psupergroup_t sg)
 {
   sgl->remove(sg);
+  notify_sg_changed(sg);
 }
 
 //--------------------------------------------------------------------------
@@ -443,6 +447,12 @@ pnodegroup_t groupman_t::combine_ngl(pnodegroup_list_t ngl)
   if (dest_ng == NULL)
     return NULL;
 
+  // The destination super group changes too
+  pnodedef_t dest_nd = dest_ng->get_first_node();
+  nodeloc_t *dest_loc = dest_nd == NULL ? NULL : find_nodeid_loc(dest_nd->nid);
+  if (dest_loc != NULL)
+    notify_sg_changed(dest_loc->sg);
+
   for (nodegroup_list_t::iterator it = ngl->begin();
        it != ngl->end(); 
        ++it)
@@ -477,6 +487,7 @@ pnodegroup_t groupman_t::combine_ngl(pnodegroup_list_t ngl)
 
     // Remove this node group from the super group
     loc->sg->remove_nodegroup(ng, false);
+    notify_sg_changed(loc->sg);
     if (loc->sg->empty())
     {
       remove_supergroup(
@@ -522,6 +533,7 @@ pnodegroup_t groupman_t::move_nodes_to_ng(pnodegroup_t ng)
 
     // Remove the node from its NG
     loc->ng->remove(loc->nd);
+    notify_sg_changed(loc->sg);
 
     // Empty NG? remove it
     if (loc->ng->empty())
@@ -534,6 +546,8 @@ pnodegroup_t groupman_t::move_nodes_to_ng(pnodegroup_t ng)
     // Add the node to the new NG
     new_ng->add_node(loc->nd);
   }
+  if (sg0 != NULL)
+    notify_sg_changed(sg0);
   // Reinitialize lookups
   initialize_lookups();
 
@@ -764,4 +778,6 @@ void groupman_t::reset_groupping()
 
   // Reinitialize lookups
   initialize_lookups();
+
+  notify_groups_reset();
 }
@@ -216,6 +216,25 @@ struct nodeloc_t
   }
 };
 
+//--------------------------------------------------------------------------
+/**
+* @brief Receives the groupping changes of a group manager
+*/
+class groupman_listener_t
+{
+public:
+  /**
+  * @brief A super group was added, removed or its node groups or attributes changed.
+  *        A removed super group may already be freed: do not dereference it
+  */
+  virtual void on_sg_changed(psupergroup_t sg) = 0;
+
+  /**
+  * @brief All the groups were cleared or replaced
+  */
+  virtual void on_groups_reset() = 0;
+};
+
 //--------------------------------------------------------------------------
 /**
 * @brief Group management class
@@ -223,6 +242,7 @@ struct nodeloc_t
 class groupman_t
 {
 private:
+  groupman_listener_t *listener;
   /**
   * @brief NodeId node location lookup map
   */
@@ -296,7 +316,31 @@ public:
   /**
   * @ctor Default constructor
   */
-  groupman_t() { }
+  groupman_t(): listener(NULL) { }
+
+  /**
+  * @brief Set the object notified of the groupping changes (NULL to stop)
+  */
+  inline void set_listener(groupman_listener_t *listener)
+  {
+    this->listener = listener;
+  }
+
+  /**
+  * @brief Notify that a super group changed. Callers editing the groups
+  *        directly (not through groupman_t) must call it
+  */
+  inline void notify_sg_changed(psupergroup_t sg)
+  {
+    if (listener != NULL)
+      listener->on_sg_changed(sg);
+  }
+
+  inline void notify_groups_reset()
+  {
+    if (listener != NULL)
+      listener->on_groups_reset();
+  }
 
   /**
   * @dtor Destructor
@@ -0,0 +1,604 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Graph layout module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+                                - The node texts are part of the layout keys
+                                - The changed nodes are pushed down in one pass over the nodes sorted by top
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <map>
+#include <string.h>
+#include "gvlayout.h"
+#include <netnode.hpp>
+
+//--------------------------------------------------------------------------
+// Saved layout format
+static const uint32 LAYOUT_MAGIC   = 0x314C5347; // "GSL1"
+static const uint32 LAYOUT_VERSION = 2;
+
+//--------------------------------------------------------------------------
+// Vertical gap between the nodes moved to make room for a changed node
+static const int NODE_MARGIN = 20;
+
+//--------------------------------------------------------------------------
+static const uint64 FNV64_BASIS = 0xCBF29CE484222325ULL;
+static const uint64 FNV64_PRIME = 0x00000100000001B3ULL;
+
+inline void fnv64_int(uint64 &h, int v)
+{
+  uint32 u = uint32(v);
+  for (int i=0; i < 4; i++, u >>= 8)
+  {
+    h ^= u & 0xFF;
+    h *= FNV64_PRIME;
+  }
+}
+
+//--------------------------------------------------------------------------
+static void put_bytes(
+    qvector<uchar> &buf,
+    const void *data,
+    size_t size)
+{
+  const uchar *p = (const uchar *)data;
+  buf.insert(buf.end(), p, p + size);
+}
+
+inline void put_int(qvector<uchar> &buf, int v)
+{
+  put_bytes(buf, &v, sizeof(v));
+}
+
+static bool get_bytes(
+    const uchar *&ptr,
+    const uchar *end,
+    void *data,
+    size_t size)
+{
+  if (size_t(end - ptr) < size)
+    return false;
+
+  memcpy(data, ptr, size);
+  ptr += size;
+  return true;
+}
+
+inline bool get_int(const uchar *&ptr, const uchar *end, int &v)
+{
+  return get_bytes(ptr, end, &v, sizeof(v));
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Sort the saved edges by source then destination
+*/
+struct saved_edge_less_t
+{
+  template <class T> bool operator()(const T &e1, const T &e2) const
+  {
+    return e1.src < e2.src || (e1.src == e2.src && e1.dst < e2.dst);
+  }
+};
+
+//--------------------------------------------------------------------------
+inline bool rects_overlap(const rect_t &r1, const rect_t &r2)
+{
+  return    r1.left < r2.right
+         && r2.left < r1.right
+         && r1.top < r2.bottom + NODE_MARGIN
+         && r2.top < r1.bottom + NODE_MARGIN;
+}
+
+//--------------------------------------------------------------------------
+gvlayout_t::gvlayout_t()
+{
+  clear();
+}
+
+//--------------------------------------------------------------------------
+void gvlayout_t::clear()
+{
+  grouping_hash = 0;
+  layout_type = layout_none;
+  node_keys.qclear();
+  rects.qclear();
+  member_nids.qclear();
+  member_nodes.qclear();
+  edges.qclear();
+}
+
+//--------------------------------------------------------------------------
+uint32 gvlayout_t::hash_text(const char *text)
+{
+  uint64 h = FNV64_BASIS;
+  for (; *text != '\0'; ++text)
+  {
+    h ^= uchar(*text);
+    h *= FNV64_PRIME;
+  }
+  return uint32(h ^ (h >> 32));
+}
+
+//--------------------------------------------------------------------------
+uint32 gvlayout_t::get_node_key(const intvec_t &members, uint32 text)
+{
+  uint64 h = FNV64_BASIS;
+  for (size_t i=0; i < members.size(); i++)
+    fnv64_int(h, members[i]);
+  fnv64_int(h, int(text));
+
+  return uint32(h ^ (h >> 32));
+}
+
+//--------------------------------------------------------------------------
+uint64 gvlayout_t::compute_hash(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts)
+{
+  uint64 h = FNV64_BASIS;
+  fnv64_int(h, mg->current_layout);
+
+  int nodes_count = mg->size();
+  fnv64_int(h, nodes_count);
+  intvec_t succs;
+  for (int n=0; n < nodes_count; n++)
+  {
+    // Members
+    if (size_t(n) < members.size())
+    {
+      const intvec_t &m = members[n];
+      fnv64_int(h, int(m.size()));
+      for (size_t i=0; i < m.size(); i++)
+        fnv64_int(h, m[i]);
+    }
+
+    // Text: the node size follows it
+    if (size_t(n) < texts.size())
+      fnv64_int(h, int(texts[n]));
+
+    // Edges, in any order
+    int nsucc = mg->nsucc(n);
+    succs.resize(nsucc);
+    for (int i=0; i < nsucc; i++)
+      succs[i] = mg->succ(n, i);
+    std::sort(succs.begin(), succs.end());
+
+    fnv64_int(h, nsucc);
+    for (int i=0; i < nsucc; i++)
+      fnv64_int(h, succs[i]);
+  }
+  return h;
+}
+
+//--------------------------------------------------------------------------
+int gvlayout_t::find_member_node(int nid) const
+{
+  const int *begin = member_nids.empty() ? NULL : &member_nids[0];
+  const int *end = begin + member_nids.size();
+  const int *p = std::lower_bound(begin, end, nid);
+  return (p == end || *p != nid) ? -1 : member_nodes[p - begin];
+}
+
+//--------------------------------------------------------------------------
+int gvlayout_t::find_edge(int src, int dst) const
+{
+  saved_edge_t key;
+  key.src = src;
+  key.dst = dst;
+
+  const saved_edge_t *begin = edges.empty() ? NULL : &edges[0];
+  const saved_edge_t *end = begin + edges.size();
+  const saved_edge_t *p = std::lower_bound(begin, end, key, saved_edge_less_t());
+  return (p == end || p->src != src || p->dst != dst) ? -1 : int(p - begin);
+}
+
+//--------------------------------------------------------------------------
+void gvlayout_t::capture(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts)
+{
+  clear();
+
+  grouping_hash = compute_hash(mg, members, texts);
+  layout_type = mg->current_layout;
+
+  int nodes_count = mg->size();
+  node_keys.resize(nodes_count);
+  rects.resize(nodes_count);
+
+  // Node id to node pairs, sorted by node id
+  qvector<std::pair<int, int> > nid_nodes;
+  for (int n=0; n < nodes_count; n++)
+  {
+    rects[n] = mg->nrect(n);
+    if (size_t(n) >= members.size())
+      continue;
+
+    const intvec_t &m = members[n];
+    node_keys[n] = get_node_key(m, size_t(n) < texts.size() ? texts[n] : 0);
+    for (size_t i=0; i < m.size(); i++)
+      nid_nodes.push_back(std::make_pair(m[i], n));
+  }
+  std::sort(nid_nodes.begin(), nid_nodes.end());
+  member_nids.resize(nid_nodes.size());
+  member_nodes.resize(nid_nodes.size());
+  for (size_t i=0; i < nid_nodes.size(); i++)
+  {
+    member_nids[i] = nid_nodes[i].first;
+    member_nodes[i] = nid_nodes[i].second;
+  }
+
+  // Edge routes
+  for (int n=0; n < nodes_count; n++)
+  {
+    for (int i=0, nsucc=mg->nsucc(n); i < nsucc; i++)
+    {
+      int dst = mg->succ(n, i);
+      edge_info_t *ei = mg->get_edge(::edge_t(n, dst));
+      if (ei == NULL)
+        continue;
+
+      saved_edge_t &e = edges.push_back();
+      e.src = n;
+      e.dst = dst;
+      e.srcoff = ei->srcoff;
+      e.dstoff = ei->dstoff;
+      e.points = ei->layout;
+    }
+  }
+  std::sort(edges.begin(), edges.end(), saved_edge_less_t());
+}
+
+//--------------------------------------------------------------------------
+bool gvlayout_t::apply(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts) const
+{
+  // Renamed or commented nodes do not fit their saved rectangles anymore
+  int nodes_count = mg->size();
+  if (    empty()
+       || int(rects.size()) != nodes_count
+       || layout_type != mg->current_layout
+       || grouping_hash != compute_hash(mg, members, texts))
+  {
+    return false;
+  }
+
+  for (int n=0; n < nodes_count; n++)
+    mg->nrect(n) = rects[n];
+
+  for (size_t i=0; i < edges.size(); i++)
+  {
+    const saved_edge_t &e = edges[i];
+    edge_info_t *ei = mg->get_edge(::edge_t(e.src, e.dst));
+    if (ei == NULL)
+      continue;
+
+    ei->srcoff = e.srcoff;
+    ei->dstoff = e.dstoff;
+    ei->layout = e.points;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void gvlayout_t::build_graph(mutable_graph_t *mg) const
+{
+  mg->clear();
+  mg->resize(int(rects.size()));
+  for (size_t i=0; i < edges.size(); i++)
+    mg->add_edge(edges[i].src, edges[i].dst, NULL);
+}
+
+//--------------------------------------------------------------------------
+size_t gvlayout_t::memory_usage() const
+{
+  size_t mem = sizeof(*this)
+             + rects.size() * (sizeof(rect_t) + sizeof(uint32))
+             + member_nids.size() * 2 * sizeof(int);
+  for (size_t i=0; i < edges.size(); i++)
+    mem += sizeof(saved_edge_t) + edges[i].points.size() * sizeof(point_t);
+  return mem;
+}
+
+//--------------------------------------------------------------------------
+bool gvlayout_t::seed(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts,
+    int max_changed_pct) const
+{
+  int nodes_count = mg->size();
+  if (    empty()
+       || nodes_count == 0
+       || int(members.size()) != nodes_count
+       || layout_type != mg->current_layout)
+  {
+    return false;
+  }
+
+  // Match the nodes by their members and text
+  std::map<uint32, int> prev_by_key;
+  for (size_t i=0; i < node_keys.size(); i++)
+    prev_by_key[node_keys[i]] = int(i);
+
+  // A node whose size changed is placed again too
+  intvec_t prev_node;
+  prev_node.resize(nodes_count);
+  boolvec_t changed;
+  changed.resize(nodes_count);
+  int changed_count = 0;
+  for (int n=0; n < nodes_count; n++)
+  {
+    uint32 text = size_t(n) < texts.size() ? texts[n] : 0;
+    std::map<uint32, int>::const_iterator it = prev_by_key.find(get_node_key(members[n], text));
+    prev_node[n] = it == prev_by_key.end() ? -1 : it->second;
+
+    const rect_t &r = mg->nrect(n);
+    changed[n] =    prev_node[n] == -1
+                 || rects[prev_node[n]].width() != r.width()
+                 || rects[prev_node[n]].height() != r.height();
+    if (changed[n])
+      ++changed_count;
+  }
+  if (changed_count * 100 > nodes_count * max_changed_pct)
+    return false;
+
+  // Bounds of the previous layout: brand new nodes go below it
+  int min_left = rects[0].left, max_bottom = rects[0].bottom;
+  for (size_t i=1; i < rects.size(); i++)
+  {
+    min_left = qmin(min_left, rects[i].left);
+    max_bottom = qmax(max_bottom, rects[i].bottom);
+  }
+
+  qvector<rect_t> placed;
+  placed.resize(nodes_count);
+  for (int n=0; n < nodes_count; n++)
+  {
+    const rect_t &r = mg->nrect(n);
+
+    // Anchor the node where it was or where its first member was
+    point_t anchor(min_left, max_bottom + NODE_MARGIN);
+    int pn = prev_node[n];
+    if (pn == -1)
+    {
+      const intvec_t &m = members[n];
+      for (size_t i=0; i < m.size() && pn == -1; i++)
+        pn = find_member_node(m[i]);
+    }
+    if (pn != -1)
+      anchor = point_t(rects[pn].left, rects[pn].top);
+
+    placed[n] = rect_t(anchor.x, anchor.y, anchor.x + r.width(), anchor.y + r.height());
+  }
+
+  // Push the changed nodes down until they overlap no settled node. The
+  // settled nodes are visited once by top edge: the node only moves down,
+  // so a node it was pushed below or that was above it stays clear
+  std::multimap<int, int> settled_by_top;
+  int max_height = 0;
+  for (int n=0; n < nodes_count; n++)
+  {
+    if (changed[n])
+      continue;
+    settled_by_top.insert(std::make_pair(placed[n].top, n));
+    max_height = qmax(max_height, placed[n].height());
+  }
+
+  for (int n=0; n < nodes_count; n++)
+  {
+    if (!changed[n])
+      continue;
+
+    // The nodes starting higher than the tallest one end above this one
+    rect_t &r = placed[n];
+    std::multimap<int, int>::const_iterator it =
+        settled_by_top.lower_bound(r.top - max_height - NODE_MARGIN + 1);
+    for (; it != settled_by_top.end() && it->first < r.bottom + NODE_MARGIN; ++it)
+    {
+      const rect_t &k = placed[it->second];
+      if (!rects_overlap(r, k))
+        continue;
+
+      int dy = k.bottom + NODE_MARGIN - r.top;
+      r.top += dy;
+      r.bottom += dy;
+    }
+    settled_by_top.insert(std::make_pair(r.top, n));
+    max_height = qmax(max_height, r.height());
+  }
+
+  for (int n=0; n < nodes_count; n++)
+    mg->nrect(n) = placed[n];
+
+  // Keep the routes of the edges between unchanged nodes. The others are drawn straight
+  for (int n=0; n < nodes_count; n++)
+  {
+    for (int i=0, nsucc=mg->nsucc(n); i < nsucc; i++)
+    {
+      int dst = mg->succ(n, i);
+      edge_info_t *ei = mg->get_edge(::edge_t(n, dst));
+      if (ei == NULL)
+        continue;
+
+      int idx = changed[n] || changed[dst] ? -1 : find_edge(prev_node[n], prev_node[dst]);
+      if (idx == -1)
+      {
+        ei->layout.qclear();
+        continue;
+      }
+
+      const saved_edge_t &e = edges[idx];
+      ei->srcoff = e.srcoff;
+      ei->dstoff = e.dstoff;
+      ei->layout = e.points;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void gvlayout_t::serialize(qvector<uchar> &buf) const
+{
+  buf.qclear();
+  put_int(buf, LAYOUT_MAGIC);
+  put_int(buf, LAYOUT_VERSION);
+  put_bytes(buf, &grouping_hash, sizeof(grouping_hash));
+  put_int(buf, layout_type);
+
+  put_int(buf, int(rects.size()));
+  for (size_t i=0; i < rects.size(); i++)
+  {
+    put_int(buf, node_keys[i]);
+    put_bytes(buf, &rects[i], sizeof(rect_t));
+  }
+
+  put_int(buf, int(member_nids.size()));
+  for (size_t i=0; i < member_nids.size(); i++)
+  {
+    put_int(buf, member_nids[i]);
+    put_int(buf, member_nodes[i]);
+  }
+
+  put_int(buf, int(edges.size()));
+  for (size_t i=0; i < edges.size(); i++)
+  {
+    const saved_edge_t &e = edges[i];
+    put_int(buf, e.src);
+    put_int(buf, e.dst);
+    put_int(buf, e.srcoff);
+    put_int(buf, e.dstoff);
+    put_int(buf, int(e.points.size()));
+    for (size_t j=0; j < e.points.size(); j++)
+    {
+      put_int(buf, e.points[j].x);
+      put_int(buf, e.points[j].y);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------
+bool gvlayout_t::deserialize(
+    const uchar *ptr,
+    const uchar *end)
+{
+  clear();
+
+  int magic, version, count;
+  if (    !get_int(ptr, end, magic)
+       || !get_int(ptr, end, version)
+       || uint32(magic) != LAYOUT_MAGIC
+       || uint32(version) != LAYOUT_VERSION
+       || !get_bytes(ptr, end, &grouping_hash, sizeof(grouping_hash))
+       || !get_int(ptr, end, layout_type)
+       || !get_int(ptr, end, count)
+       || count < 0)
+  {
+    return false;
+  }
+
+  node_keys.resize(count);
+  rects.resize(count);
+  for (int i=0; i < count; i++)
+  {
+    int key;
+    if (!get_int(ptr, end, key) || !get_bytes(ptr, end, &rects[i], sizeof(rect_t)))
+      return false;
+    node_keys[i] = uint32(key);
+  }
+
+  if (!get_int(ptr, end, count) || count < 0)
+    return false;
+  member_nids.resize(count);
+  member_nodes.resize(count);
+  for (int i=0; i < count; i++)
+  {
+    if (!get_int(ptr, end, member_nids[i]) || !get_int(ptr, end, member_nodes[i]))
+      return false;
+  }
+
+  if (!get_int(ptr, end, count) || count < 0)
+    return false;
+  edges.resize(count);
+  for (int i=0; i < count; i++)
+  {
+    saved_edge_t &e = edges[i];
+    int npoints;
+    if (    !get_int(ptr, end, e.src)
+         || !get_int(ptr, end, e.dst)
+         || !get_int(ptr, end, e.srcoff)
+         || !get_int(ptr, end, e.dstoff)
+         || !get_int(ptr, end, npoints)
+         || npoints < 0)
+    {
+      return false;
+    }
+    e.points.resize(npoints);
+    for (int j=0; j < npoints; j++)
+    {
+      if (!get_int(ptr, end, e.points[j].x) || !get_int(ptr, end, e.points[j].y))
+        return false;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+static void get_layout_node_name(ea_t func_ea, qstring *name)
+{
+  name->sprnt("$ GS layout %a", func_ea);
+}
+
+//--------------------------------------------------------------------------
+bool gvlayout_t::load(ea_t func_ea, char mode)
+{
+  clear();
+
+  qstring name;
+  get_layout_node_name(func_ea, &name);
+  netnode node(name.c_str());
+  if (nodeidx_t(node) == BADNODE)
+    return false;
+
+  size_t size = node.blobsize(0, mode);
+  if (size == 0)
+    return false;
+
+  qvector<uchar> buf;
+  buf.resize(size);
+  if (node.getblob(&buf[0], &size, 0, mode) == NULL)
+    return false;
+
+  if (!deserialize(&buf[0], &buf[0] + size))
+  {
+    // Unknown or damaged layout
+    clear();
+    return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void gvlayout_t::save(ea_t func_ea, char mode) const
+{
+  qstring name;
+  get_layout_node_name(func_ea, &name);
+  netnode node(name.c_str(), 0, true);
+
+  qvector<uchar> buf;
+  serialize(buf);
+
+  node.delblob(0, mode);
+  node.setblob(&buf[0], buf.size(), 0, mode);
+}
@@ -0,0 +1,141 @@
+#ifndef __GVLAYOUT__
+#define __GVLAYOUT__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Graph layout module
+
+This module saves the node positions and the edge routes of a graph view
+in the database. A layout is keyed by the function address, the view mode
+and a hash of the groupping and of the node texts: an unchanged graph
+reuses it instead of being laid out again, and a slightly changed graph
+keeps the previous positions of its unchanged nodes.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include <kernwin.hpp>
+#include <graph.hpp>
+
+//--------------------------------------------------------------------------
+/**
+* @brief The sorted node ids (flowchart block ids) shown by each graph node
+*/
+typedef qvector<intvec_t> gvmembers_t;
+
+/**
+* @brief The hash of the text shown by each graph node (see hash_text())
+*/
+typedef qvector<uint32> gvtexts_t;
+
+//--------------------------------------------------------------------------
+/**
+* @brief A saved graph layout
+*/
+class gvlayout_t
+{
+private:
+  struct saved_edge_t
+  {
+    int src, dst;
+    int srcoff, dstoff;
+    pointvec_t points;
+  };
+  typedef qvector<saved_edge_t> edgevec_t;
+
+  /**
+  * @brief Hash of the groupping, the node texts, the edges and the layout type
+  */
+  uint64 grouping_hash;
+  int layout_type;
+
+  /**
+  * @brief Hash of the members and the text of each node and its rectangle
+  */
+  qvector<uint32> node_keys;
+  qvector<rect_t> rects;
+
+  /**
+  * @brief The node showing a given node id, sorted by node id
+  */
+  intvec_t member_nids, member_nodes;
+
+  edgevec_t edges;
+
+  static uint32 get_node_key(const intvec_t &members, uint32 text);
+  void serialize(qvector<uchar> &buf) const;
+  bool deserialize(const uchar *ptr, const uchar *end);
+  int find_member_node(int nid) const;
+  int find_edge(int src, int dst) const;
+
+public:
+  gvlayout_t();
+
+  /**
+  * @brief Hash a node text
+  */
+  static uint32 hash_text(const char *text);
+
+  /**
+  * @brief Compute the groupping hash of a graph
+  */
+  static uint64 compute_hash(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts);
+
+  void clear();
+  inline bool empty() const { return rects.empty(); }
+  inline uint64 get_hash() const { return grouping_hash; }
+
+  /**
+  * @brief Remember the current layout of a graph
+  */
+  void capture(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts);
+
+  /**
+  * @brief Recreate the nodes and the edges of the captured graph
+  */
+  void build_graph(mutable_graph_t *mg) const;
+
+  /**
+  * @brief Return the memory used in bytes
+  */
+  size_t memory_usage() const;
+
+  /**
+  * @brief Restore this layout on the same graph with the same node texts
+  * @return False if the graph does not match: seed() a new layout instead
+  */
+  bool apply(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts) const;
+
+  /**
+  * @brief Move the unchanged nodes of a freshly laid out graph back to their
+  *        position in this layout. The changed nodes (other members, text or
+  *        size) are placed where their members used to be
+  * @param max_changed_pct - maximum percentage of changed nodes to seed the layout
+  * @return False if too many nodes changed and the fresh layout was kept
+  */
+  bool seed(
+    mutable_graph_t *mg,
+    const gvmembers_t &members,
+    const gvtexts_t &texts,
+    int max_changed_pct) const;
+
+  /**
+  * @brief Load / save the layout of a function view mode from / to the database
+  */
+  bool load(ea_t func_ea, char mode);
+  void save(ea_t func_ea, char mode) const;
+};
+
+#endif
@@ -0,0 +1,215 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Hint cache module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "hintcache.h"
+#include <bytes.hpp>
+
+//--------------------------------------------------------------------------
+// Default count of cached hints
+static const size_t DEF_MAX_ENTRIES = 64;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Sort the block ids by address
+*/
+struct nid_ea_less_t
+{
+  const qflow_chart_t *fc;
+
+  nid_ea_less_t(const qflow_chart_t *fc): fc(fc)
+  {
+  }
+
+  bool operator()(int n1, int n2) const
+  {
+    return fc->blocks[n1].startEA < fc->blocks[n2].startEA;
+  }
+};
+
+//--------------------------------------------------------------------------
+static uint32 hash_nids(const intvec_t &nids)
+{
+  // FNV-1a
+  uint32 h = 2166136261u;
+  for (size_t i=0; i < nids.size(); i++)
+  {
+    h ^= uint32(nids[i]);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+//--------------------------------------------------------------------------
+bool hintcache_t::key_t::operator<(const key_t &r) const
+{
+  if (func_ea != r.func_ea)
+    return func_ea < r.func_ea;
+  if (counter != r.counter)
+    return counter < r.counter;
+  if (members_hash != r.members_hash)
+    return members_hash < r.members_hash;
+  if (members_count != r.members_count)
+    return members_count < r.members_count;
+  return max_lines < r.max_lines;
+}
+
+//--------------------------------------------------------------------------
+hintcache_t::hintcache_t()
+{
+  max_entries = DEF_MAX_ENTRIES;
+  hits = misses = 0;
+}
+
+//--------------------------------------------------------------------------
+hintcache_t *hintcache_t::instance()
+{
+  static hintcache_t cache;
+  return &cache;
+}
+
+//--------------------------------------------------------------------------
+void hintcache_t::clear()
+{
+  entries.clear();
+  lookup.clear();
+}
+
+//--------------------------------------------------------------------------
+void hintcache_t::set_max_entries(size_t n)
+{
+  max_entries = n;
+  while (entries.size() > max_entries)
+  {
+    lookup.erase(entries.back().key);
+    entries.pop_back();
+  }
+}
+
+//--------------------------------------------------------------------------
+void hintcache_t::build_hint(
+    const qflow_chart_t &fc,
+    const fctext_t &ft,
+    const intvec_t &nids,
+    int max_lines,
+    qstring *out)
+{
+  intvec_t order;
+  for (size_t i=0; i < nids.size(); i++)
+  {
+    if (nids[i] >= 0 && nids[i] < ft.size() && nids[i] < fc.size())
+      order.push_back(nids[i]);
+  }
+  std::sort(order.begin(), order.end(), nid_ea_less_t(&fc));
+
+  // Summary statistics
+  int insn_count = 0;
+  ea_t min_ea = BADADDR, max_ea = 0;
+  for (size_t i=0; i < order.size(); i++)
+  {
+    const qbasic_block_t &block = fc.blocks[order[i]];
+    if (block.startEA >= block.endEA)
+      continue;
+
+    if (min_ea == BADADDR || block.startEA < min_ea)
+      min_ea = block.startEA;
+    if (block.endEA > max_ea)
+      max_ea = block.endEA;
+
+    for (ea_t ea=block.startEA; ea < block.endEA && ea != BADADDR; ea=next_head(ea, block.endEA))
+    {
+      if (isCode(getFlags(ea)))
+        ++insn_count;
+    }
+  }
+
+  out->sprnt("%d block(s), %d instruction(s)", int(order.size()), insn_count);
+  if (min_ea != BADADDR)
+    out->cat_sprnt(", %a..%a (%a bytes)", min_ea, max_ea, max_ea - min_ea);
+  out->append("\n\n");
+
+  // The disassembly up to the line budget
+  int lines = 0, skipped = 0;
+  for (size_t i=0; i < order.size(); i++)
+  {
+    const char *text = ft.get_text(order[i]);
+    const char *end = text + ft.get_length(order[i]);
+    while (text < end)
+    {
+      const char *eol = std::find(text, end, '\n');
+      if (eol != end)
+        ++eol;
+
+      if (max_lines == 0 || lines < max_lines)
+      {
+        out->append(text, eol - text);
+        ++lines;
+      }
+      else
+      {
+        ++skipped;
+      }
+      text = eol;
+    }
+  }
+  if (skipped != 0)
+    out->cat_sprnt("\n... %d more line(s)\n", skipped);
+}
+
+//--------------------------------------------------------------------------
+const char *hintcache_t::get_hint(
+    const qflow_chart_t &fc,
+    const fctext_t &ft,
+    uint32 counter,
+    const intvec_t &nids,
+    int max_lines)
+{
+  key_t key;
+  key.func_ea = fc.bounds.startEA;
+  key.counter = counter;
+  key.members_hash = hash_nids(nids);
+  key.members_count = int(nids.size());
+  key.max_lines = max_lines;
+
+  entry_map_t::iterator it = lookup.find(key);
+  if (it != lookup.end())
+  {
+    if (it->second->nids == nids)
+    {
+      ++hits;
+
+      // Move to the front
+      entries.splice(entries.begin(), entries, it->second);
+      return entries.front().hint.c_str();
+    }
+
+    // Same hash, other group: replace it
+    entries.erase(it->second);
+    lookup.erase(it);
+  }
+  ++misses;
+
+  entries.push_front(entry_t());
+  entry_t &e = entries.front();
+  e.key = key;
+  e.nids = nids;
+  build_hint(fc, ft, nids, max_lines, &e.hint);
+  lookup[key] = entries.begin();
+
+  // The new entry is at the front and is never trimmed
+  while (entries.size() > qmax(max_entries, size_t(1)))
+  {
+    lookup.erase(entries.back().key);
+    entries.pop_back();
+  }
+  return e.hint.c_str();
+}
@@ -0,0 +1,102 @@
+#ifndef __HINTCACHE__
+#define __HINTCACHE__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Hint cache module
+
+This module builds the hints of the groupped nodes when they are hovered.
+A hint starts with summary statistics of the group followed by the
+disassembly of its blocks cut at a line budget. Recent hints are kept in
+a cache shared by all the graph views.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <list>
+#include <map>
+#include <pro.h>
+#include <gdl.hpp>
+#include "fctext.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Cache of the group hints
+*/
+class hintcache_t
+{
+private:
+  struct key_t
+  {
+    ea_t func_ea;
+    uint32 counter;
+    uint32 members_hash;
+    int members_count;
+    int max_lines;
+
+    bool operator<(const key_t &r) const;
+  };
+
+  struct entry_t
+  {
+    key_t key;
+
+    /**
+    * @brief The block ids, to tell apart groups with the same hash
+    */
+    intvec_t nids;
+    qstring hint;
+  };
+  typedef std::list<entry_t> entry_list_t;
+  typedef std::map<key_t, entry_list_t::iterator> entry_map_t;
+
+  /**
+  * @brief Most recent entries first
+  */
+  entry_list_t entries;
+  entry_map_t lookup;
+
+  size_t max_entries;
+  uint32 hits, misses;
+
+  hintcache_t();
+
+  /**
+  * @brief Build the hint of a group
+  */
+  static void build_hint(
+    const qflow_chart_t &fc,
+    const fctext_t &ft,
+    const intvec_t &nids,
+    int max_lines,
+    qstring *out);
+
+public:
+  /**
+  * @brief Return the cache shared by all the views
+  */
+  static hintcache_t *instance();
+
+  /**
+  * @brief Return the hint of a group of blocks
+  * @param nids - the block ids of the group
+  * @param counter - the flowchart change counter the text was rendered at
+  * @param max_lines - maximum disassembly lines (0 = no limit)
+  */
+  const char *get_hint(
+    const qflow_chart_t &fc,
+    const fctext_t &ft,
+    uint32 counter,
+    const intvec_t &nids,
+    int max_lines);
+
+  void set_max_entries(size_t n);
+  void clear();
+
+  inline uint32 get_hits() const { return hits; }
+  inline uint32 get_misses() const { return misses; }
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Instruction decoder module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include <string.h>
+#include "insndec.h"
+#include <bytes.hpp>
+
+//--------------------------------------------------------------------------
+ida_insn_decoder_t *ida_insn_decoder_t::instance()
+{
+  static ida_insn_decoder_t decoder;
+  return &decoder;
+}
+
+//--------------------------------------------------------------------------
+bool ida_insn_decoder_t::decode(ea_t ea, insn_desc_t *insn)
+{
+  int len = decode_insn(ea);
+  if (len <= 0)
+    return false;
+
+  insn->itype = cmd.itype;
+  insn->size = len;
+  insn->nops = 0;
+  for (int i=0; i < UA_MAXOP; i++)
+  {
+    const op_t &op = cmd.Operands[i];
+    if (op.type == o_void)
+      break;
+    insn->ops[insn->nops++] = get_op_code(op.n, op.type);
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void ida_insn_decoder_t::get_bytes(ea_t ea, uchar *buf, size_t size)
+{
+  if (!get_many_bytes(ea, buf, size))
+    memset(buf, 0, size);
+}
+
+//--------------------------------------------------------------------------
+ea_t synth_insn_decoder_t::add_insn(ea_t ea, const insn_desc_t &insn)
+{
+  insns[ea] = insn;
+  return ea + insn.size;
+}
+
+//--------------------------------------------------------------------------
+ea_t synth_insn_decoder_t::add_insn(
+    ea_t ea,
+    uint16 itype,
+    int size,
+    int nops,
+    const int *ops)
+{
+  insn_desc_t insn;
+  insn.itype = itype;
+  insn.size = size;
+  insn.nops = 0;
+  for (int i=0; i < nops && i < UA_MAXOP; i++)
+  {
+    // The decoder stops at the first void operand
+    if (ops[i*2 + 1] == o_void)
+      break;
+    insn.ops[insn.nops++] = get_op_code(ops[i*2], ops[i*2 + 1]);
+  }
+  return add_insn(ea, insn);
+}
+
+//--------------------------------------------------------------------------
+void synth_insn_decoder_t::set_bytes(ea_t ea, const uchar *buf, size_t size)
+{
+  for (size_t i=0; i < size; i++)
+    bytes[ea + i] = buf[i];
+}
+
+//--------------------------------------------------------------------------
+void synth_insn_decoder_t::clear()
+{
+  insns.clear();
+  bytes.clear();
+}
+
+//--------------------------------------------------------------------------
+bool synth_insn_decoder_t::decode(ea_t ea, insn_desc_t *insn)
+{
+  std::map<ea_t, insn_desc_t>::const_iterator it = insns.find(ea);
+  if (it == insns.end())
+    return false;
+
+  *insn = it->second;
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void synth_insn_decoder_t::get_bytes(ea_t ea, uchar *buf, size_t size)
+{
+  for (size_t i=0; i < size; i++)
+  {
+    std::map<ea_t, uchar>::const_iterator it = bytes.find(ea + i);
+    buf[i] = it == bytes.end() ? 0 : it->second;
+  }
+}
@@ -0,0 +1,131 @@
+#ifndef __INSNDEC__
+#define __INSNDEC__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Instruction decoder module
+
+The block features are extracted through a decoder interface instead of
+calling the IDA decoder directly. The IDA decoder is the default; a
+synthetic instruction stream can be decoded instead when the features are
+computed outside of IDA.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <map>
+#include <pro.h>
+#include <ua.hpp>
+
+//--------------------------------------------------------------------------
+/**
+* @brief What the matchers need to know about an instruction
+*/
+struct insn_desc_t
+{
+  uint16 itype;
+  int size;
+
+  /**
+  * @brief Count of operands and their codes: operand number * o_last + type
+  */
+  int nops;
+  uchar ops[UA_MAXOP];
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Operand code of an operand
+*/
+inline uchar get_op_code(int n, int type)
+{
+  return uchar((n * o_last) + type);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Instruction decoder interface
+*/
+class insn_decoder_t
+{
+public:
+  virtual ~insn_decoder_t()
+  {
+  }
+
+  /**
+  * @brief Decode the instruction at the given address
+  * @return false if there is no instruction
+  */
+  virtual bool decode(ea_t ea, insn_desc_t *insn) = 0;
+
+  /**
+  * @brief Read bytes. Unavailable bytes are zero
+  */
+  virtual void get_bytes(ea_t ea, uchar *buf, size_t size) = 0;
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief The IDA decoder
+*/
+class ida_insn_decoder_t: public insn_decoder_t
+{
+public:
+  virtual bool decode(ea_t ea, insn_desc_t *insn);
+  virtual void get_bytes(ea_t ea, uchar *buf, size_t size);
+
+  /**
+  * @brief Return the shared instance
+  */
+  static ida_insn_decoder_t *instance();
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Decoder of a synthetic instruction stream. It lets the features
+*        (and the matchers) run outside of IDA, from instructions described
+*        by the caller
+*/
+class synth_insn_decoder_t: public insn_decoder_t
+{
+private:
+  std::map<ea_t, insn_desc_t> insns;
+  std::map<ea_t, uchar> bytes;
+
+public:
+  /**
+  * @brief Add an instruction, replacing the one at the same address
+  * @return the address following the instruction
+  */
+  ea_t add_insn(ea_t ea, const insn_desc_t &insn);
+
+  /**
+  * @brief Add an instruction from its itype, size and operands
+  * @param ops - 'nops' pairs of operand number and operand type
+  * @return the address following the instruction
+  */
+  ea_t add_insn(
+      ea_t ea,
+      uint16 itype,
+      int size,
+      int nops = 0,
+      const int *ops = NULL);
+
+  /**
+  * @brief Set the bytes read at the given address
+  */
+  void set_bytes(ea_t ea, const uchar *buf, size_t size);
+
+  /**
+  * @brief Forget all the instructions and bytes
+  */
+  void clear();
+
+  virtual bool decode(ea_t ea, insn_desc_t *insn);
+  virtual void get_bytes(ea_t ea, uchar *buf, size_t size);
+};
+
+#endif
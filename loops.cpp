@@ -0,0 +1,210 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Loops module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "loops.h"
+
+//--------------------------------------------------------------------------
+int compute_sccs(
+    const fcgraph_t &g,
+    intvec_t &comp)
+{
+  int node_count = g.size();
+
+  comp.qclear();
+  comp.resize(node_count, -1);
+
+  intvec_t index, low;
+  index.resize(node_count, -1);
+  low.resize(node_count, 0);
+  intvec_t scc_stk, stk_node, stk_edge;
+
+  int counter = 0, scc_count = 0;
+  for (int r=0; r < node_count; r++)
+  {
+    if (index[r] != -1)
+      continue;
+
+    index[r] = low[r] = counter++;
+    scc_stk.push_back(r);
+    stk_node.push_back(r);
+    stk_edge.push_back(0);
+
+    // Iterative DFS, the recursion is simulated with the node/edge stacks
+    while (!stk_node.empty())
+    {
+      int n = stk_node.back();
+      int &e = stk_edge.back();
+      if (e < g.nsucc(n))
+      {
+        int s = g.succ(n, e++);
+        if (index[s] == -1)
+        {
+          index[s] = low[s] = counter++;
+          scc_stk.push_back(s);
+          stk_node.push_back(s);
+          stk_edge.push_back(0);
+        }
+        // Still on the component stack?
+        else if (comp[s] == -1 && index[s] < low[n])
+        {
+          low[n] = index[s];
+        }
+        continue;
+      }
+
+      stk_node.pop_back();
+      stk_edge.pop_back();
+
+      // Is this node the root of a component?
+      if (low[n] == index[n])
+      {
+        int m;
+        do
+        {
+          m = scc_stk.back();
+          scc_stk.pop_back();
+          comp[m] = scc_count;
+        } while (m != n);
+        ++scc_count;
+      }
+
+      // Propagate the low link to the parent
+      if (!stk_node.empty())
+      {
+        int p = stk_node.back();
+        if (low[n] < low[p])
+          low[p] = low[n];
+      }
+    }
+  }
+  return scc_count;
+}
+
+//--------------------------------------------------------------------------
+void loopforest_t::clear()
+{
+  loops.qclear();
+  node_loop.qclear();
+}
+
+//--------------------------------------------------------------------------
+int loopforest_t::find_top(int l, intvec_t &top)
+{
+  while (top[l] != l)
+  {
+    // Path halving
+    top[l] = top[top[l]];
+    l = top[l];
+  }
+  return l;
+}
+
+//--------------------------------------------------------------------------
+bool loopforest_t::build(dominators_t &doms)
+{
+  clear();
+
+  const fcgraph_t &g = *doms.graph();
+  const domtree_t &dt = doms.get_domtree();
+
+  int node_count = g.size();
+  if (node_count == 0)
+    return false;
+
+  node_loop.resize(node_count, -1);
+
+  // Outermost enclosing loop found so far, per loop
+  intvec_t top;
+  intvec_t worklist;
+
+  // Descendants have a higher preorder index: walking backward visits inner headers first
+  for (int i=dt.preorder_count() - 1; i >= 0; i--)
+  {
+    int h = dt.preorder_node(i);
+    int l = int(loops.size());
+
+    // Seed the body walk with the sources of the back edges
+    worklist.qclear();
+    for (int ipred=0, npred=g.npred(h); ipred < npred; ipred++)
+    {
+      int p = g.pred(h, ipred);
+      if (dt.dominates(h, p))
+        worklist.push_back(p);
+    }
+    if (worklist.empty())
+      continue;
+
+    loop_t &loop = loops.push_back();
+    loop.header = h;
+    loop.nodes.push_back(h);
+    node_loop[h] = l;
+    top.push_back(l);
+
+    // Walk the predecessors backward up to the header
+    while (!worklist.empty())
+    {
+      int n = worklist.back();
+      worklist.pop_back();
+
+      // Only the nodes dominated by the header belong to its natural loop
+      if (!dt.dominates(h, n))
+        continue;
+
+      int t = node_loop[n];
+      if (t == -1)
+      {
+        node_loop[n] = l;
+        loop.nodes.push_back(n);
+      }
+      else
+      {
+        // Already known: either in this loop or in a nested loop
+        t = find_top(t, top);
+        if (t == l)
+          continue;
+
+        // Adopt the nested loop and continue from its header
+        loops[t].parent = l;
+        loop.children.push_back(t);
+        top[t] = l;
+        n = loops[t].header;
+      }
+
+      for (int ipred=0, npred=g.npred(n); ipred < npred; ipred++)
+        worklist.push_back(g.pred(n, ipred));
+    }
+  }
+
+  // Parents have higher ids than their children
+  for (int l=0; l < int(loops.size()); l++)
+  {
+    loop_t &loop = loops[l];
+    loop.size = int(loop.nodes.size());
+    for (size_t i=0; i < loop.children.size(); i++)
+      loop.size += loops[loop.children[i]].size;
+  }
+  for (int l=int(loops.size()) - 1; l >= 0; l--)
+  {
+    loop_t &loop = loops[l];
+    loop.depth = loop.parent == -1 ? 1 : loops[loop.parent].depth + 1;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void loopforest_t::get_loop_nodes(int l, intvec_t &nodes) const
+{
+  const loop_t &loop = loops[l];
+  nodes.insert(nodes.end(), loop.nodes.begin(), loop.nodes.end());
+  for (size_t i=0; i < loop.children.size(); i++)
+    get_loop_nodes(loop.children[i], nodes);
+}
@@ -0,0 +1,118 @@
+#ifndef __LOOPS__
+#define __LOOPS__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Loops module
+
+This module computes the strongly connected components and the loop nesting
+forest of a flowchart.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include "domtree.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Compute the strongly connected components of a graph (Tarjan).
+*        Components are numbered in reverse topological order
+* @param comp - receives the component id of each node
+* @return The components count
+*/
+int compute_sccs(
+  const fcgraph_t &g,
+  intvec_t &comp);
+
+//--------------------------------------------------------------------------
+/**
+* @brief A natural loop
+*/
+struct loop_t
+{
+  /**
+  * @brief The loop header: the target of the back edges
+  */
+  int header;
+
+  /**
+  * @brief Enclosing loop or -1 for an outermost loop
+  */
+  int parent;
+
+  /**
+  * @brief Nesting depth. Outermost loops have a depth of 1
+  */
+  int depth;
+
+  /**
+  * @brief Total count of nodes in the loop, including the nested loops
+  */
+  int size;
+
+  /**
+  * @brief Nodes that belong to this loop but not to a nested loop.
+  *        The header comes first
+  */
+  intvec_t nodes;
+
+  /**
+  * @brief Nested loops
+  */
+  intvec_t children;
+
+  loop_t(): header(-1), parent(-1), depth(0), size(0)
+  {
+  }
+};
+typedef qvector<loop_t> loop_vec_t;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Loop nesting forest of a flowchart.
+*        Nested loops always have a lower id than their enclosing loop
+*/
+class loopforest_t
+{
+private:
+  loop_vec_t loops;
+
+  /**
+  * @brief The innermost loop holding each node or -1
+  */
+  intvec_t node_loop;
+
+  /**
+  * @brief Return the outermost loop found so far that encloses 'l'
+  */
+  int find_top(int l, intvec_t &top);
+
+public:
+  /**
+  * @brief Build the forest from the back edges (edges whose target dominates their source)
+  */
+  bool build(dominators_t &doms);
+
+  /**
+  * @brief Clear the forest
+  */
+  void clear();
+
+  inline int size() const { return int(loops.size()); }
+  inline const loop_t &operator[](int l) const { return loops[l]; }
+
+  /**
+  * @brief Return the innermost loop holding a node or -1
+  */
+  inline int get_node_loop(int n) const { return node_loop[n]; }
+
+  /**
+  * @brief Return all the nodes of a loop (nested ones included). The header comes first
+  */
+  void get_loop_nodes(int l, intvec_t &nodes) const;
+};
+
+#endif
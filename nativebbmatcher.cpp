@@ -0,0 +1,942 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Native BBMatcher module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+                                - Prefilter the frequency tables comparison by a signature
+                                - Compare by frequency only the LSH candidates of the MinHash sketches
+                                - The block features come from bbfeatures_t
+                                - The instructions decoder can be replaced
+                                - Memoize the successors matching across the grown paths
+                                - Grow the paths on a work stealing pool
+                                - Group the paths by Weisfeiler-Lehman subgraph fingerprints
+                                - Find the paths covered by a kept one with per node owner bitmaps
+                                - The single entry checks are dominators_t node set queries
+                                - The frequency matches are labelled by a hash of their common
+                                  characteristics, so the workers do not share a lock
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include "nativebbmatcher.h"
+#include "util.h"
+#include "workpool.h"
+
+//--------------------------------------------------------------------------
+// Minimal size of a well formed function in blocks
+static const int MIN_FUNCTION_SIZE = 4;
+
+// Default LSH banding of the frequency sketches (as in bb_match.py)
+static const int DEF_LSH_BANDS = 16;
+static const int DEF_LSH_ROWS  = 2;
+
+// Count of paths grown between two merges of the results
+static const int MAX_GROW_BATCH = 16384;
+
+// Seeds of the two lanes of the subgraph fingerprints (as in bb_match.py)
+static const uint64 WL_SEEDS[2] = { 0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL };
+static const uint64 WL_SUCCS = 0x165667B19E3779F9ULL;
+static const uint64 WL_PREDS = 0x27D4EB2F165667C5ULL;
+
+// Seed of the hashes of the common characteristics of the frequency matches
+static const uint64 FREQ_SEED = 0x85EBCA77C2B2AE63ULL;
+
+// Tokens of the successors matching memo
+static const int TOKEN_NO_MATCH = -1;
+static const int TOKEN_UNKNOWN  = -2;
+
+// Kinds of the node hashes a path is made of
+enum
+{
+  TK_ITYPE1 = 0,
+  TK_ITYPE2 = 1,
+  TK_FREQ   = 2,
+  TK_COUNT
+};
+
+//--------------------------------------------------------------------------
+static inline int make_token(int id, int kind)
+{
+  return id * TK_COUNT + kind;
+}
+
+//--------------------------------------------------------------------------
+NativeBBMatcher::NativeBBMatcher(): decoder(NULL), threads(0)
+{
+  lsh_bands = DEF_LSH_BANDS;
+  lsh_rows = DEF_LSH_ROWS;
+}
+
+//--------------------------------------------------------------------------
+NativeBBMatcher::~NativeBBMatcher()
+{
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::grow_ctx_t::reset(int count)
+{
+  succ_memo.clear();
+  succ_tokens.qclear();
+  freq_ids.clear();
+  freq_hashes.qclear();
+  visited1.qclear();
+  visited1.resize(count, 0);
+  visited2.qclear();
+  visited2.resize(count, 0);
+  in_path1.qclear();
+  in_path1.resize(count, 0);
+  in_path2.qclear();
+  in_path2.resize(count, 0);
+  pos_in_path1.qclear();
+  pos_in_path1.resize(count, 0);
+  stamp = 0;
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::SetLSHParams(int bands, int rows)
+{
+  lsh_bands = qmax(bands, 0);
+  lsh_rows = qmax(rows, 1);
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::clear()
+{
+  nodes.clear();
+  graph.clear();
+  features.clear();
+  hash_groups.clear();
+  hash_group_of.clear();
+  full_groups.clear();
+  entry_groups.clear();
+  full_by_head.clear();
+  entry_by_head.clear();
+  full_ids.clear();
+  entry_ids.clear();
+  full_paths.clear();
+  entry_paths.clear();
+  grow_ctxs.clear();
+  grow_tasks.clear();
+  grown.clear();
+  wellformed.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Tell whether two blocks agree on all the rows of a band
+*/
+bool NativeBBMatcher::lsh_candidates(int n1, int n2) const
+{
+  if (lsh_bands <= 0)
+    return true;
+
+  const uint64 *s1 = features.get_sketch(n1);
+  const uint64 *s2 = features.get_sketch(n2);
+  for (int b=0, count=lsh_bands * lsh_rows; b < count; b += lsh_rows)
+  {
+    if (std::equal(s1 + b, s1 + b + lsh_rows, s2 + b))
+      return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::load_nodes(const qflow_chart_t &fc)
+{
+  int count = fc.size();
+  features.build(fc, lsh_bands * lsh_rows, decoder);
+  nodes.resize(count);
+  for (int n=0; n < count; n++)
+  {
+    node_t &nd = nodes[n];
+    nd.start = fc.blocks[n].startEA;
+    nd.end = fc.blocks[n].endEA;
+
+    // BBMan links a successor when either block is visited: the successors
+    // with a lower id come first, then the others in the flowchart order
+    intvec_t &succs = nd.succs;
+    for (int i=0, nsucc=fc.nsucc(n); i < nsucc; i++)
+    {
+      int s = fc.succ(n, i);
+      if (s < n && std::find(succs.begin(), succs.end(), s) == succs.end())
+        succs.push_back(s);
+    }
+    std::sort(succs.begin(), succs.end());
+    for (int i=0, nsucc=fc.nsucc(n); i < nsucc; i++)
+    {
+      int s = fc.succ(n, i);
+      if (s >= n && std::find(succs.begin(), succs.end(), s) == succs.end())
+        succs.push_back(s);
+    }
+
+    for (int i=0, npred=fc.npred(n); i < npred; i++)
+    {
+      int p = fc.pred(n, i);
+      if (std::find(nd.preds.begin(), nd.preds.end(), p) == nd.preds.end())
+        nd.preds.push_back(p);
+    }
+  }
+
+  graph.build(fc);
+  if (count > 0)
+    doms.build(graph);
+
+  int nthreads = threads > 0 ? threads : get_cpu_count();
+  grow_ctxs.resize(qmax(nthreads, 1));
+  for (size_t i=0; i < grow_ctxs.size(); i++)
+    grow_ctxs[i].reset(count);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Group the blocks with the same itype2 hash. Groups are ordered
+*        by their first block (hashBBMatch())
+*/
+void NativeBBMatcher::group_hashes()
+{
+  int count = int(nodes.size());
+
+  intvec_t hash_count(features.hash2_count(), 0);
+  for (int n=0; n < count; n++)
+    ++hash_count[features.get_hash2(n)];
+
+  intvec_t group_of_hash(features.hash2_count(), -1);
+  hash_group_of.resize(count, -1);
+  for (int n=0; n < count; n++)
+  {
+    int h = features.get_hash2(n);
+    if (hash_count[h] < 2)
+      continue;
+
+    if (group_of_hash[h] == -1)
+    {
+      group_of_hash[h] = int(hash_groups.size());
+      hash_groups.push_back();
+    }
+    hash_group_of[n] = group_of_hash[h];
+    hash_groups[group_of_hash[h]].push_back(n);
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Match two nodes by one of their hashes or by their instruction
+*        characteristics frequencies. Returns the node hash to use in the path.
+*        The hash of a frequency match is the hash of the common characteristics,
+*        its token is the id the worker gave to it
+*/
+bool NativeBBMatcher::match(grow_ctx_t &ctx, int n1, int n2, int kind, int *token)
+{
+  if (kind == TK_ITYPE1)
+  {
+    *token = make_token(features.get_hash1(n1), kind);
+    return features.get_hash1(n1) == features.get_hash1(n2);
+  }
+  if (kind == TK_ITYPE2)
+  {
+    *token = make_token(features.get_hash2(n1), kind);
+    return features.get_hash2(n1) == features.get_hash2(n2);
+  }
+
+  // Empty blocks have no frequencies. Cheap prefilter: no common characteristic
+  int t1 = features.get_icount(n1), t2 = features.get_icount(n2);
+  if (t1 == 0 || t2 == 0 || (features.get_freq_sig(n1) & features.get_freq_sig(n2)) == 0)
+    return false;
+
+  // Only the LSH candidates are checked
+  if (!lsh_candidates(n1, n2))
+    return false;
+
+  int coverage;
+  if (t1 <= 4 || t2 <= 4)
+    coverage = 50;
+  else if (t1 <= 6 || t2 <= 6)
+    coverage = 60;
+  else if (t1 <= 8 || t2 <= 8)
+    coverage = 75;
+  else
+    coverage = 85;
+
+  // match_block_frequencies(): walk the smaller table
+  int ns = features.get_freq_size(n1) > features.get_freq_size(n2) ? n2 : n1;
+  int nb = ns == n1 ? n2 : n1;
+  const int *s_keys = features.get_freq_keys(ns), *s_counts = features.get_freq_counts(ns);
+  const int *b_keys = features.get_freq_keys(nb), *b_counts = features.get_freq_counts(nb);
+  size_t s_size = features.get_freq_size(ns), b_size = features.get_freq_size(nb);
+
+  uint64 common = FREQ_SEED;
+  int ncommon = 0;
+  double tp = 0;
+  int ct1 = 0, ct2 = 0;
+  for (size_t i=0, j=0; i < s_size && j < b_size; )
+  {
+    if (s_keys[i] < b_keys[j])
+    {
+      ++i;
+    }
+    else if (b_keys[j] < s_keys[i])
+    {
+      ++j;
+    }
+    else
+    {
+      int v1 = s_counts[i], v2 = b_counts[j];
+      ct1 += v1;
+      ct2 += v2;
+      tp += double(qmin(v1, v2) * 100) / double(qmax(v1, v2));
+      common = mix64(common ^ uint64(uint32(s_keys[i])));
+      ++ncommon;
+      ++i;
+      ++j;
+    }
+  }
+
+  // The common counts are taken relative to the first and the second table
+  double cp1 = double(100 * ct1) / double(t1);
+  double cp2 = double(100 * ct2) / double(t2);
+  if (cp1 <= coverage || cp2 <= coverage)
+    return false;
+
+  if (ncommon == 0 || tp / ncommon <= 95)
+    return false;
+
+  std::map<uint64, int>::iterator it = ctx.freq_ids.find(common);
+  if (it == ctx.freq_ids.end())
+  {
+    it = ctx.freq_ids.insert(std::make_pair(common, int(ctx.freq_hashes.size()))).first;
+    ctx.freq_hashes.push_back(common);
+  }
+  *token = make_token(it->second, TK_FREQ);
+  return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Return the offset of the successors matching memo of 'n1' and
+*        'parent2'. The tokens are computed on demand
+*/
+size_t NativeBBMatcher::get_succ_matches(grow_ctx_t &ctx, int n1, int parent2)
+{
+  uint64 key = (uint64(n1) << 32) | uint32(parent2);
+  std::map<uint64, size_t>::iterator it = ctx.succ_memo.find(key);
+  if (it != ctx.succ_memo.end())
+    return it->second;
+
+  size_t off = ctx.succ_tokens.size();
+  ctx.succ_tokens.resize(off + nodes[parent2].succs.size() * TK_COUNT, TOKEN_UNKNOWN);
+  ctx.succ_memo[key] = off;
+  return off;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Find a successor of 'parent2' matching 'n1'. All the examined
+*        successors are added to 'ctx.tmp_visited2'
+*/
+bool NativeBBMatcher::find_match_in_succs(
+    grow_ctx_t &ctx,
+    int n1,
+    int parent2,
+    int kind,
+    int *m,
+    int *token)
+{
+  size_t memo = get_succ_matches(ctx, n1, parent2);
+  const intvec_t &succs = nodes[parent2].succs;
+  for (size_t i=0; i < succs.size(); i++)
+  {
+    int s = succs[i];
+    if (ctx.visited2[s] == ctx.stamp || s == parent2 || ctx.in_path2[s] == ctx.stamp)
+      continue;
+
+    ctx.tmp_visited2.push_back(s);
+    int &t = ctx.succ_tokens[memo + i * TK_COUNT + kind];
+    if (t == TOKEN_UNKNOWN && !match(ctx, n1, s, kind, &t))
+      t = TOKEN_NO_MATCH;
+    if (t == TOKEN_NO_MATCH || n1 == s)
+      continue;
+
+    *token = t;
+    *m = s;
+    return true;
+  }
+  return false;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Count the distinct colors
+*/
+static int count_colors(const qvector<uint64> &colors, qvector<uint64> &sorted)
+{
+  sorted = colors;
+  std::sort(sorted.begin(), sorted.end());
+  return int(std::unique(sorted.begin(), sorted.end()) - sorted.begin());
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Find the order of the nodes of a path so their colors are 'ref'.
+*        The nodes of the same color keep their order
+*/
+static bool align_colors(
+    const fp128vec_t &ref,
+    const fp128vec_t &colors,
+    intvec_t &order)
+{
+  if (ref.size() != colors.size())
+    return false;
+
+  intvec_t used(colors.size(), 0);
+  order.qclear();
+  for (size_t k=0; k < ref.size(); k++)
+  {
+    size_t p = 0;
+    while (p < colors.size() && (used[p] || colors[p] != ref[k]))
+      ++p;
+    if (p == colors.size())
+      return false;
+    used[p] = 1;
+    order.push_back(int(p));
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Add two matched paths to the group of their fingerprint. They are
+*        ordered as the first paths of the group
+*/
+void NativeBBMatcher::add_path(
+    qvector<pathgroup_t> &groups,
+    int_2dvec_t &by_head,
+    fp128_ids_t &ids,
+    intvec_ids_t &known,
+    int head,
+    const fp128_t &fp,
+    const fp128vec_t &colors,
+    const intvec_t &path1,
+    const intvec_t &path2)
+{
+  int gid;
+  fp128_ids_t::iterator it = ids.find(fp);
+  if (it == ids.end())
+  {
+    gid = int(groups.size());
+    ids[fp] = gid;
+    pathgroup_t &pg = groups.push_back();
+    pg.head = head;
+    pg.colors = colors;
+    by_head[head].push_back(gid);
+  }
+  else
+  {
+    gid = it->second;
+  }
+
+  pathgroup_t &pg = groups[gid];
+  intvec_t p1 = path1, p2 = path2, order;
+  if (colors != pg.colors && align_colors(pg.colors, colors, order))
+  {
+    for (size_t i=0; i < order.size(); i++)
+    {
+      p1[i] = path1[order[i]];
+      p2[i] = path2[order[i]];
+    }
+  }
+
+  const intvec_t *paths[2] = { &p1, &p2 };
+  intvec_t key;
+  for (int i=0; i < 2; i++)
+  {
+    key.qclear();
+    key.push_back(gid);
+    key.insert(key.end(), paths[i]->begin(), paths[i]->end());
+    if (known.insert(std::make_pair(key, 0)).second)
+      pg.paths.push_back(*paths[i]);
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief One lane of the Weisfeiler-Lehman refinement: the color of a node
+*        is mixed with the sums of the colors of its successors and
+*        predecessors until the partition of the nodes by color is stable
+*/
+void NativeBBMatcher::wl_refine(grow_ctx_t &ctx, int count, uint64 seed)
+{
+  qvector<uint64> &colors = ctx.wl_colors;
+  colors.resize(count);
+  for (int p=0; p < count; p++)
+    colors[p] = mix64(ctx.wl_labels[p] ^ seed);
+
+  int classes = count_colors(colors, ctx.wl_sorted);
+  for (int r=0; r < count; r++)
+  {
+    ctx.wl_succs.qclear();
+    ctx.wl_succs.resize(count, 0);
+    ctx.wl_preds.qclear();
+    ctx.wl_preds.resize(count, 0);
+    for (size_t e=0; e < ctx.wl_edges.size(); e += 2)
+    {
+      int from = ctx.wl_edges[e], to = ctx.wl_edges[e + 1];
+      ctx.wl_succs[from] += colors[to];
+      ctx.wl_preds[to] += colors[from];
+    }
+    for (int p=0; p < count; p++)
+    {
+      colors[p] = mix64(
+          colors[p]
+        + mix64(ctx.wl_succs[p] ^ WL_SUCCS) * 3
+        + mix64(ctx.wl_preds[p] ^ WL_PREDS) * 5);
+    }
+
+    int n = count_colors(colors, ctx.wl_sorted);
+    if (n == classes)
+      break;
+    classes = n;
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Weisfeiler-Lehman fingerprint of the subgraph made of the first
+*        'count' nodes of the first grown path and the edges between them.
+*        The initial color of a node is its matched hash, the head is marked.
+*        The frequency matches are colored by their hash and not by the token
+*        the worker gave to them
+*/
+void NativeBBMatcher::get_fingerprint(
+    grow_ctx_t &ctx,
+    const grown_t &g,
+    int count,
+    fp128_t *fp,
+    fp128vec_t &colors)
+{
+  ctx.wl_labels.resize(count);
+  ctx.wl_edges.qclear();
+  for (int p=0; p < count; p++)
+  {
+    int t = g.tokens[p];
+    uint64 label = t % TK_COUNT == TK_FREQ
+                 ? ctx.freq_hashes[t / TK_COUNT] * TK_COUNT + TK_FREQ
+                 : uint64(t);
+    ctx.wl_labels[p] = label * 2 + (p == 0 ? 1 : 0);
+
+    const intvec_t &succs = nodes[g.path1[p]].succs;
+    for (size_t i=0; i < succs.size(); i++)
+    {
+      int s = succs[i];
+      if (ctx.in_path1[s] == ctx.stamp && ctx.pos_in_path1[s] < count)
+      {
+        ctx.wl_edges.push_back(p);
+        ctx.wl_edges.push_back(ctx.pos_in_path1[s]);
+      }
+    }
+  }
+
+  colors.resize(count);
+  for (int lane=0; lane < 2; lane++)
+  {
+    wl_refine(ctx, count, WL_SEEDS[lane]);
+    uint64 sum = uint64(count);
+    for (int p=0; p < count; p++)
+    {
+      uint64 c = ctx.wl_colors[p];
+      sum += c;
+      if (lane == 0)
+        colors[p].lo = c;
+      else
+        colors[p].hi = c;
+    }
+    if (lane == 0)
+      fp->lo = mix64(sum);
+    else
+      fp->hi = mix64(sum);
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Grow two matching paths from a pair of blocks with the same hash.
+*        Only the scratch state of the worker is modified
+*/
+void NativeBBMatcher::grow_paths(
+    grow_ctx_t &ctx,
+    int head,
+    int n1,
+    int n2,
+    grown_t &out)
+{
+  int stamp = ++ctx.stamp;
+
+  // The paths are also the breadth first queue
+  intvec_t &path1 = out.path1, &path2 = out.path2, &tokens = out.tokens;
+  path1.qclear();
+  path2.qclear();
+  tokens.qclear();
+  out.head = head;
+  out.entry_count = 0;
+
+  path1.push_back(n1);
+  path2.push_back(n2);
+  tokens.push_back(make_token(features.get_hash2(n1), TK_ITYPE2));
+  ctx.in_path1[n1] = stamp;
+  ctx.pos_in_path1[n1] = 0;
+  ctx.in_path2[n2] = stamp;
+
+  for (size_t q=0; q < path1.size(); q++)
+  {
+    int x = path1[q], y = path2[q];
+    ctx.tmp_visited2.qclear();
+
+    const intvec_t &succs = nodes[x].succs;
+    for (size_t i=0; i < succs.size(); i++)
+    {
+      int l = succs[i];
+      if (ctx.visited1[l] == stamp || l == x || ctx.in_path1[l] == stamp)
+        continue;
+      ctx.visited1[l] = stamp;
+
+      int m, token;
+      if (   !find_match_in_succs(ctx, l, y, TK_ITYPE1, &m, &token)
+          && !find_match_in_succs(ctx, l, y, TK_ITYPE2, &m, &token)
+          && !find_match_in_succs(ctx, l, y, TK_FREQ, &m, &token))
+      {
+        continue;
+      }
+
+      ctx.in_path1[l] = stamp;
+      ctx.pos_in_path1[l] = int(path1.size());
+      ctx.in_path2[m] = stamp;
+      ctx.visited2[m] = stamp;
+      path1.push_back(l);
+      path2.push_back(m);
+      tokens.push_back(token);
+    }
+
+    for (size_t i=0; i < ctx.tmp_visited2.size(); i++)
+      ctx.visited2[ctx.tmp_visited2[i]] = stamp;
+  }
+
+  int count = int(path1.size());
+  if (count < 2)
+    return;
+
+  // makeSubgraphSingleEntryPoint() drops the last node while a node other
+  // than the head is entered from outside: keep the longest such prefix
+  int entry_count = doms.single_entry_prefix(path1, ctx.marks);
+  out.entry_count = entry_count;
+
+  get_fingerprint(ctx, out, count, &out.fp, out.colors);
+  if (entry_count > 1)
+    get_fingerprint(ctx, out, entry_count, &out.entry_fp, out.entry_colors);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Record a pair of grown paths in the path groups
+*/
+void NativeBBMatcher::add_grown(const grown_t &g)
+{
+  if (g.path1.size() < 2)
+    return;
+
+  add_path(
+      full_groups,
+      full_by_head,
+      full_ids,
+      full_paths,
+      g.head,
+      g.fp,
+      g.colors,
+      g.path1,
+      g.path2);
+
+  if (g.entry_count < 2)
+    return;
+
+  intvec_t path1(g.path1.begin(), g.path1.begin() + g.entry_count);
+  intvec_t path2(g.path2.begin(), g.path2.begin() + g.entry_count);
+  add_path(
+      entry_groups,
+      entry_by_head,
+      entry_ids,
+      entry_paths,
+      g.head,
+      g.entry_fp,
+      g.entry_colors,
+      path1,
+      path2);
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::grow_job(void *ud, int worker, int job)
+{
+  NativeBBMatcher *self = (NativeBBMatcher *)ud;
+  const grow_task_t &task = self->grow_tasks[job];
+  self->grow_paths(
+      self->grow_ctxs[worker],
+      task.head,
+      task.n1,
+      task.n2,
+      self->grown[job]);
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Grow the paths of the pending tasks and record them in the task
+*        order, so the result does not depend on the count of threads
+*/
+void NativeBBMatcher::run_grow_tasks()
+{
+  int count = int(grow_tasks.size());
+  if (grown.size() < grow_tasks.size())
+    grown.resize(grow_tasks.size());
+
+  workpool_t pool;
+  pool.run(count, int(grow_ctxs.size()), grow_job, this);
+
+  for (int i=0; i < count; i++)
+    add_grown(grown[i]);
+  grow_tasks.qclear();
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::find_subgraphs()
+{
+  full_by_head.resize(hash_groups.size());
+  entry_by_head.resize(hash_groups.size());
+  for (size_t g=0; g < hash_groups.size(); g++)
+  {
+    const intvec_t &members = hash_groups[g];
+    for (size_t z=0; z + 1 < members.size(); z++)
+    {
+      for (size_t j=z + 1; j < members.size(); j++)
+      {
+        grow_task_t &task = grow_tasks.push_back();
+        task.head = int(g);
+        task.n1 = members[z];
+        task.n2 = members[j];
+        if (grow_tasks.size() >= MAX_GROW_BATCH)
+          run_grow_tasks();
+      }
+    }
+  }
+  run_grow_tasks();
+  grown.clear();
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Tell whether all the nodes of a path have a common owner. Bit 'k'
+*        of the owners of a node is set when the node is in the k-th kept path
+*/
+static bool have_common_owner(
+    const qvector<qvector<uint64> > &owners,
+    const intvec_t &path,
+    qvector<uint64> &common)
+{
+  common = owners[path[0]];
+  bool any = false;
+  for (size_t w=0; w < common.size() && !any; w++)
+    any = common[w] != 0;
+
+  for (size_t i=1; i < path.size() && any; i++)
+  {
+    const qvector<uint64> &o = owners[path[i]];
+    if (o.size() < common.size())
+      common.resize(o.size());
+
+    any = false;
+    for (size_t w=0; w < common.size(); w++)
+    {
+      common[w] &= o[w];
+      any |= common[w] != 0;
+    }
+  }
+  return any;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Keep the single entry paths that do not overlap bigger ones
+*        (sortByPathLen() and GetMatchedWellFormedFunctions())
+*/
+void NativeBBMatcher::get_wellformed(int min_size)
+{
+  std::map<int, intvec_t> by_size;
+  for (size_t g=0; g < entry_by_head.size(); g++)
+  {
+    const intvec_t &eg = entry_by_head[g];
+    for (size_t i=0; i < eg.size(); i++)
+      by_size[int(entry_groups[eg[i]].paths[0].size())].push_back(eg[i]);
+  }
+
+  // The visited path groups by head, in the order they were first visited
+  intvec_t heads;
+  int_2dvec_t visited(hash_groups.size());
+
+  // A path is skipped when it is in one of the kept paths
+  qvector<qvector<uint64> > owners(nodes.size());
+  qvector<uint64> common;
+  int moved_count = 0;
+  for (std::map<int, intvec_t>::reverse_iterator it=by_size.rbegin();
+       it != by_size.rend() && it->first >= min_size;
+       ++it)
+  {
+    const intvec_t &egs = it->second;
+    for (size_t i=0; i < egs.size(); i++)
+    {
+      pathgroup_t &pg = entry_groups[egs[i]];
+      if (visited[pg.head].empty())
+        heads.push_back(pg.head);
+      visited[pg.head].push_back(egs[i]);
+
+      // subgraphHasExternalJumpsIntoIt()
+      if (!doms.is_single_entry(pg.paths[0], pg.paths[0][0]))
+        continue;
+
+      for (size_t j=0; j < pg.paths.size(); j++)
+      {
+        if (!have_common_owner(owners, pg.paths[j], common))
+          pg.normalized.push_back(pg.paths[j]);
+      }
+
+      if (pg.normalized.size() < 2)
+        pg.normalized.clear();
+
+      for (size_t j=0; j < pg.normalized.size(); j++, moved_count++)
+      {
+        const intvec_t &path = pg.normalized[j];
+        size_t w = moved_count / 64;
+        for (size_t k=0; k < path.size(); k++)
+        {
+          qvector<uint64> &o = owners[path[k]];
+          if (o.size() <= w)
+            o.resize(w + 1, 0);
+          o[w] |= 1ULL << (moved_count % 64);
+        }
+      }
+    }
+  }
+
+  for (size_t i=0; i < heads.size(); i++)
+  {
+    const intvec_t &egs = visited[heads[i]];
+    for (size_t j=0; j < egs.size(); j++)
+    {
+      const int_2dvec_t &normalized = entry_groups[egs[j]].normalized;
+      if (!normalized.empty())
+        wellformed.push_back(normalized);
+    }
+  }
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::AnalyzeFlowchart(
+    const qflow_chart_t &fc,
+    int_3dvec_t &result)
+{
+  clear();
+  load_nodes(fc);
+  group_hashes();
+  find_subgraphs();
+  get_wellformed(MIN_FUNCTION_SIZE);
+  result = wellformed;
+}
+
+//--------------------------------------------------------------------------
+void NativeBBMatcher::Analyze(ea_t func_addr, int_3dvec_t &result)
+{
+  const qflow_chart_t *fc = get_func_flowchart(func_addr);
+  if (fc == NULL)
+  {
+    clear();
+    result.clear();
+    return;
+  }
+  AnalyzeFlowchart(*fc, result);
+}
+
+//--------------------------------------------------------------------------
+bool NativeBBMatcher::FindSimilar(intvec_t &node_list, int_2dvec_t &similar)
+{
+  similar.clear();
+  if (node_list.empty())
+    return false;
+
+  for (size_t i=0; i < node_list.size(); i++)
+  {
+    if (node_list[i] < 0 || node_list[i] >= int(nodes.size()))
+      return false;
+  }
+
+  // A single node is similar to all the nodes with the same hash
+  if (node_list.size() == 1)
+  {
+    int g = hash_group_of[node_list[0]];
+    if (g != -1)
+    {
+      const intvec_t &members = hash_groups[g];
+      for (size_t i=0; i < members.size(); i++)
+        similar.push_back().push_back(members[i]);
+    }
+    return true;
+  }
+
+  // Find a matched path starting with one of the nodes and holding them
+  // all, then take the nodes at the same positions in the matching paths
+  for (size_t h=0; h < node_list.size(); h++)
+  {
+    int head = node_list[h];
+    int g = hash_group_of[head];
+    if (g == -1)
+      continue;
+
+    const intvec_t &fgs = full_by_head[g];
+    for (size_t i=0; i < fgs.size(); i++)
+    {
+      const int_2dvec_t &paths = full_groups[fgs[i]].paths;
+      if (node_list.size() > paths[0].size())
+        continue;
+
+      for (size_t j=0; j < paths.size(); j++)
+      {
+        const intvec_t &path = paths[j];
+        if (path[0] != head)
+          continue;
+
+        intvec_t pos;
+        for (size_t k=0; k < node_list.size(); k++)
+        {
+          intvec_t::const_iterator it = std::find(path.begin(), path.end(), node_list[k]);
+          if (it == path.end())
+            break;
+          pos.push_back(int(it - path.begin()));
+        }
+        if (pos.size() != node_list.size())
+          continue;
+
+        for (size_t k=0; k < paths.size(); k++)
+        {
+          intvec_t subset;
+          for (size_t p=0; p < pos.size(); p++)
+            subset.push_back(paths[k][pos[p]]);
+
+          if (std::find(similar.begin(), similar.end(), subset) == similar.end())
+            similar.push_back(subset);
+        }
+        break;
+      }
+    }
+
+    if (!similar.empty())
+      break;
+  }
+  return true;
+}
@@ -0,0 +1,252 @@
+#ifndef __NATIVE_BBMATCHER_INC__
+#define __NATIVE_BBMATCHER_INC__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Native BBMatcher
+
+This module is a C++ port of the bb_match.py matcher. It finds the blocks
+with the same instructions, grows matching paths from each pair of them and
+keeps the well formed non-overlapping ones. The Python hex digests are
+replaced by interned ids, which compare the same way, and the Python dicts
+are walked in insertion order. The matched paths are grouped by the
+Weisfeiler-Lehman fingerprint of their subgraph, as in bb_match.py.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <map>
+#include <pro.h>
+#include <gdl.hpp>
+#include "bbmatcher.hpp"
+#include "bbfeatures.h"
+#include "domtree.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief 128 bits subgraph fingerprint or node color
+*/
+struct fp128_t
+{
+  uint64 lo, hi;
+
+  bool operator<(const fp128_t &r) const
+  {
+    return hi < r.hi || (hi == r.hi && lo < r.lo);
+  }
+  bool operator==(const fp128_t &r) const
+  {
+    return lo == r.lo && hi == r.hi;
+  }
+  bool operator!=(const fp128_t &r) const
+  {
+    return !(*this == r);
+  }
+};
+typedef qvector<fp128_t> fp128vec_t;
+typedef std::map<fp128_t, int> fp128_ids_t;
+
+//--------------------------------------------------------------------------
+class NativeBBMatcher: public BBMatcher
+{
+private:
+  struct node_t
+  {
+    ea_t start, end;
+
+    /**
+    * @brief Successors in the order bb_match.py visits them and predecessors
+    */
+    intvec_t succs, preds;
+  };
+
+  /**
+  * @brief Paths with the same subgraph fingerprint. The paths are ordered
+  *        so the node colors of all of them are 'colors'
+  */
+  struct pathgroup_t
+  {
+    int head;
+    fp128vec_t colors;
+    int_2dvec_t paths;
+    int_2dvec_t normalized;
+  };
+
+  qvector<node_t> nodes;
+
+  /**
+  * @brief The flowchart graph. Its node set queries tell which paths can
+  *        only be entered through their head
+  */
+  fcgraph_t graph;
+  dominators_t doms;
+
+  /**
+  * @brief The features of the blocks, decoded once per analysis
+  */
+  bbfeatures_t features;
+  insn_decoder_t *decoder;
+
+  /**
+  * @brief Blocks with the same itype2 hash (bbMatcherClass.M)
+  */
+  int_2dvec_t hash_groups;
+  intvec_t hash_group_of;
+
+  /**
+  * @brief All matched paths (pathPerNodeHashFull) and the single entry
+  *        ones (pathPerNodeHash) of each hash group. The group ids are
+  *        found by fingerprint, the known paths are the group id followed
+  *        by the path nodes
+  */
+  qvector<pathgroup_t> full_groups, entry_groups;
+  int_2dvec_t full_by_head, entry_by_head;
+  fp128_ids_t full_ids, entry_ids;
+  intvec_ids_t full_paths, entry_paths;
+
+  /**
+  * @brief The analysis result
+  */
+  int_3dvec_t wellformed;
+
+  /**
+  * @brief Path growing state of a worker. The memo of the successors
+  *        matching is shared by all the paths a worker grows: for a node
+  *        and a parent, 'succ_memo' gives the offset in 'succ_tokens' of
+  *        the match token of the node with each successor of the parent,
+  *        by each hash kind. The scratch arrays are valid when equal to 'stamp'
+  */
+  struct grow_ctx_t
+  {
+    std::map<uint64, size_t> succ_memo;
+    intvec_t succ_tokens;
+    intvec_t visited1, visited2, in_path1, in_path2, pos_in_path1, tmp_visited2;
+    int stamp;
+
+    /**
+    * @brief Hashes of the common characteristics of the frequency matches
+    *        of the worker and their ids in the worker tokens
+    */
+    std::map<uint64, int> freq_ids;
+    qvector<uint64> freq_hashes;
+
+    /**
+    * @brief Scratch of the single entry queries on 'doms'
+    */
+    nodemarks_t marks;
+
+    /**
+    * @brief Scratch of the subgraph fingerprints: the edges as position
+    *        pairs and the colors of a lane
+    */
+    intvec_t wl_edges;
+    qvector<uint64> wl_labels, wl_colors, wl_succs, wl_preds, wl_sorted;
+
+    void reset(int count);
+  };
+
+  /**
+  * @brief A pair of paths grown from two heads and the node hashes of the
+  *        first one. The first 'entry_count' nodes make the single entry paths.
+  *        The fingerprints and colors are those of the first path
+  */
+  struct grown_t
+  {
+    int head;
+    intvec_t path1, path2, tokens;
+    int entry_count;
+    fp128_t fp, entry_fp;
+    fp128vec_t colors, entry_colors;
+  };
+
+  struct grow_task_t
+  {
+    int head, n1, n2;
+  };
+
+  qvector<grow_ctx_t> grow_ctxs;
+  qvector<grow_task_t> grow_tasks;
+  qvector<grown_t> grown;
+
+  /**
+  * @brief Count of path growing threads (0 = one per processor)
+  */
+  int threads;
+
+  /**
+  * @brief LSH banding of the sketches
+  */
+  int lsh_bands, lsh_rows;
+
+  void load_nodes(const qflow_chart_t &fc);
+  void group_hashes();
+
+  bool lsh_candidates(int n1, int n2) const;
+  bool match(grow_ctx_t &ctx, int n1, int n2, int kind, int *token);
+  size_t get_succ_matches(grow_ctx_t &ctx, int n1, int parent2);
+  bool find_match_in_succs(
+      grow_ctx_t &ctx,
+      int n1,
+      int parent2,
+      int kind,
+      int *m,
+      int *token);
+
+  static void add_path(
+      qvector<pathgroup_t> &groups,
+      int_2dvec_t &by_head,
+      fp128_ids_t &ids,
+      intvec_ids_t &known,
+      int head,
+      const fp128_t &fp,
+      const fp128vec_t &colors,
+      const intvec_t &path1,
+      const intvec_t &path2);
+
+  void wl_refine(grow_ctx_t &ctx, int count, uint64 seed);
+  void get_fingerprint(
+      grow_ctx_t &ctx,
+      const grown_t &g,
+      int count,
+      fp128_t *fp,
+      fp128vec_t &colors);
+  void grow_paths(grow_ctx_t &ctx, int head, int n1, int n2, grown_t &out);
+  void add_grown(const grown_t &g);
+  static void grow_job(void *ud, int worker, int job);
+  void run_grow_tasks();
+  void find_subgraphs();
+  void get_wellformed(int min_size);
+
+public:
+  NativeBBMatcher();
+  virtual ~NativeBBMatcher();
+
+  /**
+  * @brief Forget the last analysis
+  */
+  void clear();
+
+  /**
+  * @brief Set the instructions decoder of the next analyses (NULL = IDA)
+  */
+  inline void set_decoder(insn_decoder_t *decoder) { this->decoder = decoder; }
+
+  /**
+  * @brief Set the count of threads growing the paths (0 = one per processor).
+  *        The result does not depend on it
+  */
+  inline void set_threads(int threads) { this->threads = threads; }
+
+  /**
+  * @brief Analyze a flowchart
+  */
+  void AnalyzeFlowchart(const qflow_chart_t &fc, int_3dvec_t &result);
+
+  virtual void Analyze(ea_t func_addr, int_3dvec_t &result);
+  virtual bool FindSimilar(intvec_t &node_list, int_2dvec_t &similar);
+  virtual void SetLSHParams(int bands, int rows);
+};
+
+#endif
@@ -0,0 +1,426 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Partition module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "partition.h"
+
+//--------------------------------------------------------------------------
+// Refinement passes per level
+static const int REFINE_PASSES = 4;
+
+// Allowed part weight above the average, in percent
+static const int IMBALANCE_PCT = 3;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Undirected graph with weighted nodes and edges (CSR form)
+*/
+struct wgraph_t
+{
+  intvec_t xadj, adjncy, adjwgt;
+  intvec_t vwgt;
+
+  inline int size() const { return int(vwgt.size()); }
+};
+typedef qvector<wgraph_t> wgraph_vec_t;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Scratch table used to accumulate the weights of neighbors
+*/
+struct accum_t
+{
+  intvec_t slot;
+  intvec_t keys, vals;
+
+  void init(int n)
+  {
+    slot.qclear();
+    slot.resize(n, -1);
+  }
+
+  inline void add(int key, int w)
+  {
+    int s = slot[key];
+    if (s == -1)
+    {
+      slot[key] = int(keys.size());
+      keys.push_back(key);
+      vals.push_back(w);
+    }
+    else
+    {
+      vals[s] += w;
+    }
+  }
+
+  inline int get(int key) const
+  {
+    int s = slot[key];
+    return s == -1 ? 0 : vals[s];
+  }
+
+  void reset()
+  {
+    for (size_t i=0; i < keys.size(); i++)
+      slot[keys[i]] = -1;
+    keys.qclear();
+    vals.qclear();
+  }
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Build the undirected weighted graph of a flowchart.
+*        Self loops are dropped and parallel edges are merged
+*/
+static void build_wgraph(
+    const fcgraph_t &g,
+    wgraph_t &wg)
+{
+  int n = g.size();
+  wg.vwgt.resize(n, 1);
+  wg.xadj.push_back(0);
+
+  accum_t acc;
+  acc.init(n);
+  for (int u=0; u < n; u++)
+  {
+    for (int i=0, nsucc=g.nsucc(u); i < nsucc; i++)
+    {
+      int v = g.succ(u, i);
+      if (v != u)
+        acc.add(v, 1);
+    }
+    for (int i=0, npred=g.npred(u); i < npred; i++)
+    {
+      int v = g.pred(u, i);
+      if (v != u)
+        acc.add(v, 1);
+    }
+    wg.adjncy.insert(wg.adjncy.end(), acc.keys.begin(), acc.keys.end());
+    wg.adjwgt.insert(wg.adjwgt.end(), acc.vals.begin(), acc.vals.end());
+    wg.xadj.push_back(int(wg.adjncy.size()));
+    acc.reset();
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Coarsen a graph by collapsing a heavy edge matching
+* @param cmap - receives the coarse node of each node
+* @return The coarse nodes count
+*/
+static int coarsen(
+    const wgraph_t &g,
+    int max_vwgt,
+    uint32 &seed,
+    wgraph_t &cg,
+    intvec_t &cmap)
+{
+  int n = g.size();
+
+  // Visit the nodes in a random order to avoid matching chains
+  intvec_t order;
+  order.resize(n, 0);
+  for (int i=0; i < n; i++)
+    order[i] = i;
+  for (int i=n - 1; i > 0; i--)
+  {
+    seed = seed * 1103515245 + 12345;
+    int j = int((seed >> 8) % uint32(i + 1));
+    qswap(order[i], order[j]);
+  }
+
+  intvec_t match;
+  match.resize(n, -1);
+  for (int i=0; i < n; i++)
+  {
+    int u = order[i];
+    if (match[u] != -1)
+      continue;
+
+    int best = u, best_w = 0;
+    for (int e=g.xadj[u]; e < g.xadj[u + 1]; e++)
+    {
+      int v = g.adjncy[e];
+      if (    match[v] == -1
+           && g.adjwgt[e] > best_w
+           && g.vwgt[u] + g.vwgt[v] <= max_vwgt)
+      {
+        best = v;
+        best_w = g.adjwgt[e];
+      }
+    }
+    match[u] = best;
+    match[best] = u;
+  }
+
+  // Number the coarse nodes after their lowest member
+  cmap.qclear();
+  cmap.resize(n, -1);
+  int cn = 0;
+  for (int u=0; u < n; u++)
+  {
+    if (cmap[u] == -1)
+      cmap[u] = cmap[match[u]] = cn++;
+  }
+
+  // Merge the members adjacency lists
+  cg.xadj.qclear();
+  cg.adjncy.qclear();
+  cg.adjwgt.qclear();
+  cg.vwgt.qclear();
+  cg.xadj.push_back(0);
+
+  accum_t acc;
+  acc.init(cn);
+  for (int u=0; u < n; u++)
+  {
+    int v = match[u];
+    if (v < u)
+      continue;
+
+    int c = cmap[u];
+    int w = g.vwgt[u];
+    for (int m=u; ; m=v)
+    {
+      for (int e=g.xadj[m]; e < g.xadj[m + 1]; e++)
+      {
+        int cv = cmap[g.adjncy[e]];
+        if (cv != c)
+          acc.add(cv, g.adjwgt[e]);
+      }
+      if (m == v)
+        break;
+      w += g.vwgt[v];
+    }
+    cg.vwgt.push_back(w);
+    cg.adjncy.insert(cg.adjncy.end(), acc.keys.begin(), acc.keys.end());
+    cg.adjwgt.insert(cg.adjwgt.end(), acc.vals.begin(), acc.vals.end());
+    cg.xadj.push_back(int(cg.adjncy.size()));
+    acc.reset();
+  }
+  return cn;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Split the graph in breadth first order into 'k' parts of about the same weight
+*/
+static void initial_partition(
+    const wgraph_t &g,
+    int k,
+    intvec_t &part)
+{
+  int n = g.size();
+  part.qclear();
+  part.resize(n, -1);
+
+  int64 total = 0;
+  for (int u=0; u < n; u++)
+    total += g.vwgt[u];
+
+  intvec_t queue;
+  queue.reserve(n);
+
+  boolvec_t queued;
+  queued.resize(n, false);
+
+  int64 acc = 0;
+  for (int r=0; r < n; r++)
+  {
+    if (queued[r])
+      continue;
+
+    queued[r] = true;
+    queue.push_back(r);
+    for (size_t head=queue.size() - 1; head < queue.size(); head++)
+    {
+      int u = queue[head];
+
+      // The node goes to the part its weight's middle falls in
+      int p = int(((acc * 2 + g.vwgt[u]) * k) / (total * 2));
+      part[u] = p < k ? p : k - 1;
+      acc += g.vwgt[u];
+
+      for (int e=g.xadj[u]; e < g.xadj[u + 1]; e++)
+      {
+        int v = g.adjncy[e];
+        if (!queued[v])
+        {
+          queued[v] = true;
+          queue.push_back(v);
+        }
+      }
+    }
+  }
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Greedily move the boundary nodes to the part they are most connected to.
+*        Overweight parts give away nodes even when the cut grows
+*/
+static void refine(
+    const wgraph_t &g,
+    int k,
+    intvec_t &part)
+{
+  int n = g.size();
+
+  int64 total = 0;
+  intvec_t pwgt;
+  pwgt.resize(k, 0);
+  for (int u=0; u < n; u++)
+  {
+    pwgt[part[u]] += g.vwgt[u];
+    total += g.vwgt[u];
+  }
+  int max_pwgt = int((total * (100 + IMBALANCE_PCT)) / (100 * int64(k))) + 1;
+
+  accum_t conn;
+  conn.init(k);
+  for (int pass=0; pass < REFINE_PASSES; pass++)
+  {
+    int moved = 0;
+    for (int u=0; u < n; u++)
+    {
+      int own = part[u];
+      int w = g.vwgt[u];
+
+      // Never empty a part
+      if (pwgt[own] == w)
+        continue;
+
+      for (int e=g.xadj[u]; e < g.xadj[u + 1]; e++)
+        conn.add(part[g.adjncy[e]], g.adjwgt[e]);
+
+      bool overweight = pwgt[own] > max_pwgt;
+      int internal = conn.get(own);
+      int best = -1, best_gain = 0;
+      for (size_t i=0; i < conn.keys.size(); i++)
+      {
+        int p = conn.keys[i];
+        if (p == own || pwgt[p] + w > max_pwgt)
+          continue;
+
+        int gain = conn.vals[i] - internal;
+        if (    (best == -1 && (gain > 0 || overweight || (gain == 0 && pwgt[p] + w < pwgt[own])))
+             || (best != -1 && gain > best_gain))
+        {
+          best = p;
+          best_gain = gain;
+        }
+      }
+      conn.reset();
+
+      if (best == -1)
+        continue;
+
+      part[u] = best;
+      pwgt[own] -= w;
+      pwgt[best] += w;
+      ++moved;
+    }
+    if (moved == 0)
+      break;
+  }
+}
+
+//--------------------------------------------------------------------------
+int partition_graph(
+    const fcgraph_t &g,
+    int k,
+    intvec_t &part)
+{
+  int n = g.size();
+  part.qclear();
+  if (n == 0 || k <= 0)
+    return 0;
+
+  if (k >= n)
+  {
+    // One node per part
+    part.resize(n, 0);
+    for (int u=0; u < n; u++)
+      part[u] = u;
+    return n;
+  }
+
+  //
+  // Coarsening phase
+  //
+  wgraph_vec_t levels;
+  qvector<intvec_t> cmaps;
+  build_wgraph(g, levels.push_back());
+
+  // Coarse nodes must stay lighter than a part
+  int max_vwgt = qmax(1, n / (k * 4));
+  int coarsest = qmax(k * 4, 32);
+
+  uint32 seed = 0x9E3779B9;
+  while (levels.back().size() > coarsest)
+  {
+    wgraph_t cg;
+    intvec_t cmap;
+    int fine_n = levels.back().size();
+    int cn = coarsen(levels.back(), max_vwgt, seed, cg, cmap);
+
+    // Stop when matching does not shrink the graph anymore
+    if (cn > fine_n - fine_n / 20)
+      break;
+
+    cmaps.push_back().swap(cmap);
+
+    wgraph_t &lg = levels.push_back();
+    lg.xadj.swap(cg.xadj);
+    lg.adjncy.swap(cg.adjncy);
+    lg.adjwgt.swap(cg.adjwgt);
+    lg.vwgt.swap(cg.vwgt);
+  }
+
+  //
+  // Partition the coarsest graph then project back and refine
+  //
+  intvec_t cpart;
+  initial_partition(levels.back(), k, cpart);
+  refine(levels.back(), k, cpart);
+
+  for (int lvl=int(cmaps.size()) - 1; lvl >= 0; lvl--)
+  {
+    const intvec_t &cmap = cmaps[lvl];
+
+    intvec_t fpart;
+    fpart.resize(cmap.size(), 0);
+    for (size_t u=0; u < cmap.size(); u++)
+      fpart[u] = cpart[cmap[u]];
+
+    refine(levels[lvl], k, fpart);
+    cpart.swap(fpart);
+  }
+
+  //
+  // Renumber the non empty parts by their lowest node
+  //
+  intvec_t renum;
+  renum.resize(k, -1);
+  int nparts = 0;
+  part.resize(n, 0);
+  for (int u=0; u < n; u++)
+  {
+    int &p = renum[cpart[u]];
+    if (p == -1)
+      p = nparts++;
+    part[u] = p;
+  }
+  return nparts;
+}
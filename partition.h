@@ -0,0 +1,34 @@
+#ifndef __PARTITION__
+#define __PARTITION__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Partition module
+
+This module splits a flowchart into balanced clusters with few edges
+between them, so very large functions can be viewed as a bounded count
+of nodes.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include "fcgraph.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Split a graph into 'k' balanced parts with a small edge cut.
+*        The edges direction is ignored. The graph is coarsened with heavy
+*        edge matching, the coarsest graph is split in breadth first order
+*        then the parts are refined while projecting back
+* @param part - receives the part of each node
+* @return The count of parts
+*/
+int partition_graph(
+  const fcgraph_t &g,
+  int k,
+  intvec_t &part);
+
+#endif
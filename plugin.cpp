@@ -77,6 +77,27 @@ History
                                 - Added PUBLIC define to compile-out a few experimental features
 04/16/2014 - eliasb             - Added NO_PYTHON compile define
 09/24/2014 - eliasb             - Integrated changes from Hex-Rays, thanks to Arnaud Diederen
+10/18/2026 - agent              - Propose the SESE regions as initial groupping when Analyze() has no result
+                                - Added "Collapse loop", "Expand loop" and group by loops / SCCs
+                                - Partition functions whose groupping is still too big to layout
+                                - Added the neighbourhood view mode
+                                - Flowcharts are cached across Analyze() / file loads
+                                - The function disassembly is rendered once per refresh into a shared buffer
+                                - Highlight colors come from a fixed palette keyed by the super group ID
+                                - The super groups highlighted together get distinct colors, given out
+                                  in the order of their keys so a set always gets the same colors
+                                - Selection and highlight are dense per node sets (ncolorset_t)
+                                - Repaints and relayouts are coalesced by a refresh scheduler
+                                - Find searches a trigram index of the group names and the node texts
+                                - Graph layouts are saved in the database and reused or used as a seed
+                                - Saved layouts are only reused when the node texts did not change
+                                - The inactive view mode is kept laid out so switching modes is instant
+                                - Chooser lines are updated per changed super group and formatted when painted
+                                - Groupped node hints are built on demand with a line budget and cached
+                                - Analyze() / FindSimilar() use the native matcher, the Python one can be selected or compared with it
+                                - The fuzzy block matching LSH banding is saved in the database and set in the options dialog
+                                - The native matcher grows the paths on several threads
+                                - The flowchart cache limits are saved in the database and set in the options dialog
 
 TODO
 -----------
@@ -95,18 +116,25 @@ TODO
 #pragma warning(disable: 4018 4800)
 #endif
 
+#include <algorithm>
 #include <ida.hpp>
 #include <idp.hpp>
 #include <graph.hpp>
 #include <loader.hpp>
 #include <kernwin.hpp>
+#include <lines.hpp>
 #include <diskio.hpp>
+#include <netnode.hpp>
 #include <prodir.h>
 
 #include "groupman.h"
 #include "util.h"
 #include "algo.hpp"
 #include "colorgen.h"
+#include "searchidx.h"
+#include "gvlayout.h"
+#include "hintcache.h"
+#include "nativebbmatcher.h"
 #include "pybbmatcher.h"
 
 //--------------------------------------------------------------------------
@@ -117,6 +145,9 @@ TODO
 //--------------------------------------------------------------------------
 #define MY_TABSTR "    "
 
+// Node lists longer than this are cut in the chooser lines
+static const size_t CHOOSER_LINE_MAX = MAXSTR - 16;
+
 #define STR_GS_MSG "GS: "
 
 #define BBGROUP_EXT "bbgroup"
@@ -130,10 +161,190 @@ static const char STR_OUTWIN_TITLE[]      = "Output window";
 static const char STR_IDAVIEWA_TITLE[]    = "IDA View-A";
 static const char STR_SEARCH_PROMPT[]     = "Please enter search string";
 static const char STR_DUMMY_SG_NAME[]     = "No name";
+static const char STR_GS_OPTIONS_NODE[]   = "$ GS options";
 static const char STR_GS_PY_PLGFILE[]     = "GraphSlick" SDIRCHAR "init.py";
 
 //--------------------------------------------------------------------------
-typedef std::map<int, bgcolor_t> ncolormap_t;
+// Refresh scheduler dirty flags
+enum
+{
+  RFD_COLORS   = 0x01,   // selection / highlight changed: repaint
+  RFD_TEXT     = 0x02,   // node texts changed: the node sizes change, relayout in place
+  RFD_TOPOLOGY = 0x04,   // groupping or view mode changed: rebuild and relayout
+};
+
+// Delay before serving the refresh requests
+static const int REFRESH_TICK_MS = 10;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Set of colored graph nodes. Membership is a bitset and the colors
+*        are stored in an array indexed by the node id
+*/
+class ncolorset_t
+{
+private:
+  qvector<uint32> bits;
+  qvector<bgcolor_t> colors;
+  int count;
+
+  static int popcount(uint32 v)
+  {
+    v = v - ((v >> 1) & 0x55555555);
+    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);
+    return int((((v + (v >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+  }
+
+  static int lowest_bit(uint32 v)
+  {
+    static const int debruijn[32] =
+    {
+       0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+      31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+    };
+    return debruijn[((v & (0 - v)) * 0x077CB531) >> 27];
+  }
+
+public:
+  ncolorset_t(): count(0)
+  {
+  }
+
+  /**
+  * @brief Empty the set and size it for the given count of nodes
+  */
+  void reset(int node_count)
+  {
+    bits.qclear();
+    bits.resize((node_count + 31) / 32, 0);
+    colors.qclear();
+    colors.resize(node_count, 0);
+    count = 0;
+  }
+
+  /**
+  * @brief Empty the set. The size does not change
+  */
+  void clear()
+  {
+    if (count == 0)
+      return;
+    for (size_t i=0; i < bits.size(); i++)
+      bits[i] = 0;
+    count = 0;
+  }
+
+  inline bool empty() const { return count == 0; }
+  inline int size() const { return count; }
+
+  inline bool has(int n) const
+  {
+    return n >= 0
+        && size_t(n) < colors.size()
+        && (bits[n >> 5] & (1u << (n & 31))) != 0;
+  }
+
+  inline bgcolor_t get_color(int n) const { return colors[n]; }
+
+  /**
+  * @brief Add a node or change its color
+  */
+  void set(int n, bgcolor_t clr)
+  {
+    if (n < 0)
+      return;
+
+    // Nodes beyond the graph size are unexpected, but grow anyway
+    if (size_t(n) >= colors.size())
+    {
+      bits.resize(n / 32 + 1, 0);
+      colors.resize(n + 1, 0);
+    }
+
+    uint32 &w = bits[n >> 5];
+    uint32 m = 1u << (n & 31);
+    if ((w & m) == 0)
+    {
+      w |= m;
+      ++count;
+    }
+    colors[n] = clr;
+  }
+
+  /**
+  * @brief Remove a node
+  */
+  void erase(int n)
+  {
+    if (!has(n))
+      return;
+    bits[n >> 5] &= ~(1u << (n & 31));
+    --count;
+  }
+
+  /**
+  * @brief Add the nodes [0, node_count) with the given color
+  */
+  void set_all(int node_count, bgcolor_t clr)
+  {
+    reset(node_count);
+    for (int w=0; w < node_count / 32; w++)
+      bits[w] = 0xFFFFFFFF;
+    if ((node_count & 31) != 0)
+      bits[node_count >> 5] = (1u << (node_count & 31)) - 1;
+    for (int n=0; n < node_count; n++)
+      colors[n] = clr;
+    count = node_count;
+  }
+
+  /**
+  * @brief Add the nodes of another set that are not in this one, with the given color
+  */
+  void merge(const ncolorset_t &other, bgcolor_t clr)
+  {
+    if (other.colors.size() > colors.size())
+    {
+      bits.resize(other.bits.size(), 0);
+      colors.resize(other.colors.size(), 0);
+    }
+
+    count = 0;
+    for (size_t w=0; w < bits.size(); w++)
+    {
+      uint32 added = w < other.bits.size() ? other.bits[w] & ~bits[w] : 0;
+      bits[w] |= added;
+      count += popcount(bits[w]);
+
+      for (; added != 0; added &= added - 1)
+        colors[w * 32 + lowest_bit(added)] = clr;
+    }
+  }
+
+  /**
+  * @brief Return the first node after 'n' or -1
+  */
+  int next(int n) const
+  {
+    int start = n + 1;
+    if (start < 0 || size_t(start) >= colors.size())
+      return -1;
+
+    size_t w = start >> 5;
+    uint32 v = bits[w] & (0xFFFFFFFF << (start & 31));
+    while (v == 0)
+    {
+      if (++w >= bits.size())
+        return -1;
+      v = bits[w];
+    }
+    return int(w * 32) + lowest_bit(v);
+  }
+
+  /**
+  * @brief Return the first node or -1
+  */
+  inline int first() const { return next(-1); }
+};
 
 const bgcolor_t NODE_SEL_COLOR = 0x7C75AD;
 
@@ -146,9 +357,36 @@ enum gvrefresh_modes_e
 };
 
 //--------------------------------------------------------------------------
-#define DECL_CG \
-  colorgen_t cg; \
-  cg.L_INT = -15
+/**
+* @brief Return the palette key of a super group. It only depends on the SG id
+*        so a group keeps its color across refreshes and sessions
+*/
+static const char *get_sg_color_name(psupergroup_t sg)
+{
+  return sg->id.empty() ? sg->name.c_str() : sg->id.c_str();
+}
+
+static unsigned int get_sg_color_key(psupergroup_t sg)
+{
+  return colorpalette_t::hash_str(get_sg_color_name(sg));
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Sort the super groups highlighted together by palette key and id.
+*        The colors are given out in this order, so a set of super groups
+*        always gets the same colors whatever order it was listed in
+*/
+struct sg_color_less_t
+{
+  bool operator()(psupergroup_t sg1, psupergroup_t sg2) const
+  {
+    unsigned int k1 = get_sg_color_key(sg1), k2 = get_sg_color_key(sg2);
+    if (k1 != k2)
+      return k1 < k2;
+    return strcmp(get_sg_color_name(sg1), get_sg_color_name(sg2)) < 0;
+  }
+};
 
 
 //--------------------------------------------------------------------------
@@ -167,6 +405,93 @@ struct gsoptions_t
   */
   bool no_initial_path_info;
 
+  /**
+  * @brief Propose the single-entry/single-exit regions as initial path
+  *        information when the analyzer does not return any
+  */
+  bool sese_initial_grouping;
+
+  /**
+  * @brief Regions up to that many nodes are collapsed in the initial path information
+  */
+  int sese_max_region_size;
+
+  /**
+  * @brief Partition the function when the analyzer found no path information
+  *        and there are more node groups than 'partition_node_budget'
+  */
+  bool auto_partition;
+
+  /**
+  * @brief Maximum count of nodes in the groupped view of a partitioned function
+  */
+  int partition_node_budget;
+
+  /**
+  * @brief Neighbourhood view: count of hops around the focused nodes
+  */
+  int ego_hops;
+
+  /**
+  * @brief Neighbourhood view: maximum count of shown nodes
+  */
+  int ego_max_nodes;
+
+  /**
+  * @brief Maximum count of cached function flowcharts (0 = no limit)
+  */
+  int fc_cache_max_entries;
+
+  /**
+  * @brief Maximum memory used by the cached flowcharts in bytes (0 = no limit)
+  */
+  int fc_cache_max_bytes;
+
+  /**
+  * @brief Save the graph layouts in the database and reuse them when the graph did not change
+  */
+  bool persist_layout;
+
+  /**
+  * @brief Maximum percentage of changed nodes for the saved layout to seed the new one
+  */
+  int layout_seed_max_changed;
+
+  /**
+  * @brief Maximum memory used to keep the inactive view mode in bytes (0 = no limit)
+  */
+  int view_buffer_max_bytes;
+
+  /**
+  * @brief Maximum disassembly lines in the hint of a groupped node (0 = no limit)
+  */
+  int hint_max_lines;
+
+  /**
+  * @brief Analyze with the native matcher instead of the Python one
+  */
+  bool native_matcher;
+
+  /**
+  * @brief Run both matchers and report when their results differ
+  */
+  bool compare_matchers;
+
+  /**
+  * @brief LSH banding of the fuzzy block matching: blocks are compared by
+  *        instruction frequencies only when their MinHash sketches agree on
+  *        the 'lsh_rows' entries of a band. The similarity threshold is about
+  *        (1/lsh_bands)^(1/lsh_rows): more bands or fewer rows raise the recall
+  *        (0 bands = compare all)
+  */
+  int lsh_bands;
+  int lsh_rows;
+
+  /**
+  * @brief Threads of the native matcher (0 = one per processor)
+  */
+  int matcher_threads;
+
   /**
   * @brief Manual refresh view on selection/highlight
   */
@@ -218,14 +543,69 @@ struct gsoptions_t
     graph_layout = layout_digraph;
     //;!
     no_initial_path_info = false;
+    sese_initial_grouping = true;
+    sese_max_region_size = 32;
+    auto_partition = false;
+    partition_node_budget = 1000;
+    ego_hops = 2;
+    ego_max_nodes = 200;
+    fc_cache_max_entries = 16;
+    fc_cache_max_bytes = 64 * 1024 * 1024;
+    persist_layout = true;
+    layout_seed_max_changed = 25;
+    view_buffer_max_bytes = 32 * 1024 * 1024;
+    hint_max_lines = 40;
+    native_matcher = true;
+    compare_matchers = false;
+    lsh_bands = 16;
+    lsh_rows = 2;
+    matcher_threads = 0;
   }
 
   /**
-  * @brief Show the options dialog
+  * @brief Indexes of the options saved in the database
+  */
+  enum
+  {
+    OPT_SHOW_DIALOG,
+    OPT_FC_CACHE_MAX_ENTRIES,
+    OPT_FC_CACHE_MAX_BYTES,
+    OPT_LSH_BANDS,
+    OPT_LSH_ROWS,
+  };
+
+  /**
+  * @brief Show the options dialog and save the options when it is accepted
   */
   void show_dialog()
   {
-    // TODO: askusingform
+    static const char form[] =
+      "GraphSlick options\n"
+      "\n"
+      "Flowchart cache (0 = no limit)\n"
+      "<~F~lowcharts:D:10:10::>\n"
+      "<~M~emory in MB:D:10:10::>\n"
+      "\n"
+      "Fuzzy block matching: more bands or fewer rows raise the recall (0 bands = compare all)\n"
+      "<LSH ~b~ands:D:10:10::>\n"
+      "<LSH ~r~ows per band:D:10:10::>\n"
+      "\n"
+      "<~S~how this dialog when a file is loaded:C>>\n";
+
+    sval_t fc_entries = fc_cache_max_entries;
+    sval_t fc_mb = fc_cache_max_bytes / (1024 * 1024);
+    sval_t bands = lsh_bands;
+    sval_t rows = lsh_rows;
+    ushort flags = show_options_dialog_next_time ? 1 : 0;
+    if (AskUsingForm_c(form, &fc_entries, &fc_mb, &bands, &rows, &flags) <= 0)
+      return;
+
+    fc_cache_max_entries = int(qmax(fc_entries, sval_t(0)));
+    fc_cache_max_bytes = int(qmin(qmax(fc_mb, sval_t(0)), sval_t(2047))) * 1024 * 1024;
+    lsh_bands = int(qmin(qmax(bands, sval_t(0)), sval_t(64)));
+    lsh_rows = int(qmin(qmax(rows, sval_t(1)), sval_t(64)));
+    show_options_dialog_next_time = (flags & 1) != 0;
+    save_options();
   }
 
   /**
@@ -233,7 +613,15 @@ struct gsoptions_t
   */
   void load_options()
   {
-    //TODO: load from netnode
+    netnode node(STR_GS_OPTIONS_NODE);
+    if (nodeidx_t(node) == BADNODE)
+      return;
+
+    load_bool(node, OPT_SHOW_DIALOG, &show_options_dialog_next_time);
+    load_int(node, OPT_FC_CACHE_MAX_ENTRIES, &fc_cache_max_entries);
+    load_int(node, OPT_FC_CACHE_MAX_BYTES, &fc_cache_max_bytes);
+    load_int(node, OPT_LSH_BANDS, &lsh_bands);
+    load_int(node, OPT_LSH_ROWS, &lsh_rows);
   }
 
   /**
@@ -241,7 +629,35 @@ struct gsoptions_t
   */
   void save_options()
   {
-    // TODO: save to netnode
+    netnode node(STR_GS_OPTIONS_NODE, 0, true);
+    save_int(node, OPT_SHOW_DIALOG, show_options_dialog_next_time ? 1 : 0);
+    save_int(node, OPT_FC_CACHE_MAX_ENTRIES, fc_cache_max_entries);
+    save_int(node, OPT_FC_CACHE_MAX_BYTES, fc_cache_max_bytes);
+    save_int(node, OPT_LSH_BANDS, lsh_bands);
+    save_int(node, OPT_LSH_ROWS, lsh_rows);
+  }
+
+private:
+  /**
+  * @brief Read an option value. Options that were never saved keep their default
+  */
+  static void load_int(netnode &node, int idx, int *value)
+  {
+    int v;
+    if (node.supval(idx, &v, sizeof(v)) == sizeof(v))
+      *value = v;
+  }
+
+  static void load_bool(netnode &node, int idx, bool *value)
+  {
+    int v = *value ? 1 : 0;
+    load_int(node, idx, &v);
+    *value = v != 0;
+  }
+
+  static void save_int(netnode &node, int idx, int value)
+  {
+    node.supset(idx, &value, sizeof(value));
   }
 };
 
@@ -317,6 +733,28 @@ private:
   gnodemap_t node_map;
   ng2nid_t ng2id;
   qflow_chart_t *func_fc;
+
+  /**
+  * @brief Disassembly text of the function. The nodes in 'node_map' point into it
+  */
+  fctext_t func_text;
+
+  /**
+  * @brief Search index of the super group names and ids
+  */
+  searchidx_t sg_index;
+  qvector<psupergroup_t> sg_docs;
+  std::map<psupergroup_t, int> sg_doc_ids;
+  bool sg_index_dirty;
+
+  /**
+  * @brief Search index of the node texts and the function it was built for
+  */
+  searchidx_t node_index;
+  ea_t node_index_ea;
+  int node_index_size;
+  uint32 node_index_counter;
+
   gvrefresh_modes_e refresh_mode, cur_view_mode;
 
   gsgv_actions_t *actions;
@@ -343,14 +781,114 @@ private:
 
   int idm_combine_ngs;
 
+  int idm_group_loops, idm_group_sccs;
+  int idm_partition;
+  int idm_ego_mode;
+  int idm_collapse_loop, idm_expand_loop;
+
   int idm_show_options;
 
   bool in_sel_mode;
 
-  ncolormap_t     highlighted_nodes;
-  ncolormap_t     selected_nodes;
+  ncolorset_t     highlighted_nodes;
+  ncolorset_t     selected_nodes;
+
+  /**
+  * @brief Refresh scheduler state. Repaint and relayout requests are recorded
+  *        as dirty flags and served at most once per UI idle tick
+  */
+  struct refresh_sched_t
+  {
+    /**
+    * @brief RFD_xxx flags
+    */
+    int dirty;
+
+    /**
+    * @brief Refresh mode of the pending relayout
+    */
+    gvrefresh_modes_e layout_mode;
+
+    /**
+    * @brief The idle tick timer or NULL
+    */
+    qtimer_t timer;
+
+    /**
+    * @brief Set while serving a repaint so the refresh callback keeps the layout
+    */
+    bool repaint_only;
+
+    uint32 repaint_requests, repaints;
+    uint32 layout_requests, layouts;
+  };
+  refresh_sched_t rsched;
+
+  /**
+  * @brief A laid out view mode kept aside while the other mode is shown
+  */
+  struct viewbuf_t
+  {
+    bool valid;
+
+    /**
+    * @brief Set when node texts changed: the view needs a relayout when shown again
+    */
+    bool relayout;
+
+    gnodemap_t node_map;
+    ng2nid_t ng2id;
+    gvlayout_t layout;
+    size_t mem;
+
+    viewbuf_t(): valid(false), relayout(false), mem(0)
+    {
+    }
+  };
+
+  /**
+  * @brief The single and combined views
+  */
+  viewbuf_t viewbufs[2];
+
+  /**
+  * @brief The function, flowchart size and cache change counter 'func_text' was rendered for
+  */
+  ea_t func_text_ea;
+  int func_text_size;
+  uint32 func_text_counter;
+
+  /**
+  * @brief Last node visited by the jump to next selected/highlighted node
+  */
+  int it_selected_node, it_highlighted_node;
+
+  /**
+  * @brief Neighbourhood view state. Outside of this class, node ids are
+  *        always the ids of the whole (single or combined) graph
+  */
+  bool ego_mode;
+
+  /**
+  * @brief Node ids (of the flowchart) the neighbourhood grows from
+  */
+  intvec_t ego_seed_nids;
+
+  /**
+  * @brief Adjacency of the whole graph
+  */
+  fcgraph_t ego_base;
+
+  /**
+  * @brief Shown nodes: graph node -> whole graph node and the reverse lookup
+  */
+  intvec_t ego_nodes, ego_local;
 
-  ncolormap_t::iterator it_selected_node, it_highlighted_node;
+  /**
+  * @brief Stub nodes marking the cut edges: owning graph node and text
+  */
+  intvec_t ego_stub_owner;
+  qstrvec_t ego_stub_text;
 
   /**
   * @brief Static menu item dispatcher
@@ -557,6 +1095,63 @@ private:
       promote_node_groups_to_sgs();
     }
     //
+    // Collapse / expand the loop of the selected nodes or the current node
+    //
+    else if (menu_id == idm_collapse_loop || menu_id == idm_expand_loop)
+    {
+      intvec_t nids;
+      if (!get_action_nids(nids))
+      {
+        msg(STR_GS_MSG "No selection!\n");
+        return;
+      }
+      if (menu_id == idm_collapse_loop)
+        collapse_loops(nids);
+      else
+        expand_loops(nids);
+    }
+    //
+    // Regroup the whole function by loops / SCCs
+    //
+    else if (menu_id == idm_group_loops || menu_id == idm_group_sccs)
+    {
+      build_groupman_from_loops(func_fc, menu_id == idm_group_sccs, gm, true);
+
+      // Refresh the chooser
+      actions->notify_refresh(true);
+
+      // Re-layout
+      redo_current_layout();
+    }
+    //
+    // Show only the neighbourhood of the current / selected nodes or the whole graph
+    //
+    else if (menu_id == idm_ego_mode)
+    {
+      ego_mode = !ego_mode;
+      if (ego_mode)
+      {
+        intvec_t nids;
+        if (!get_action_nids(nids))
+          nids.push_back(0);
+        ego_seed_nids.swap(nids);
+      }
+      redo_current_layout();
+    }
+    //
+    // Regroup the whole function into balanced clusters
+    //
+    else if (menu_id == idm_partition)
+    {
+      build_groupman_from_partition(func_fc, options->partition_node_budget, gm, true);
+
+      // Refresh the chooser
+      actions->notify_refresh(true);
+
+      // Re-layout
+      redo_current_layout();
+    }
+    //
     // Reset groupping
     //
     else if (menu_id == idm_reset_groupping)
@@ -580,14 +1175,16 @@ private:
       for (int i=0;i<qnumber(sel);i++)
       {
         int nid = sel[i];
-        selected_nodes[nid] = NODE_SEL_COLOR;
+        selected_nodes.set(nid, NODE_SEL_COLOR);
         sel_nodes.push_back(nid);
       }
 
       pnodegroup_list_t ngl = actions->find_similar(sel_nodes);
 
-      DECL_CG;
-      highlight_nodes(ngl, cg, options->manual_refresh_mode);
+      highlight_nodes(
+        ngl,
+        colorpalette_t::hash_int(sel_nodes[0]),
+        options->manual_refresh_mode);
       ngl->free_nodegroup(false);
       delete ngl;
     }
@@ -632,9 +1229,14 @@ private:
         va_arg(va, graph_item_t *);
         if (in_sel_mode && item1 != NULL && item1->is_node)
         {
-          toggle_select_node(
-            item1->node,
-            options->manual_refresh_mode);
+          // Stub nodes cannot be selected
+          int gr_nid = ego_to_base(item1->node);
+          if (gr_nid != -1)
+          {
+            toggle_select_node(
+              gr_nid,
+              options->manual_refresh_mode);
+          }
         }
 
         // don't ignore the click
@@ -649,12 +1251,33 @@ private:
       {
         va_arg(va, graph_viewer_t *);
 
-        // Remember the current node
+        // Remember the current node. A stub node stands for its owner
         cur_node = va_argi(va, int);
+        if (ego_mode && cur_node != -1)
+          cur_node = ego_to_base(ego_stub_to_local(cur_node));
 
         break;
       }
 
+      //
+      // A graph node was double clicked: grow the neighbourhood from it
+      //
+      case grcode_dblclicked:
+      {
+        va_arg(va, graph_viewer_t *);
+        selection_item_t *item = va_arg(va, selection_item_t *);
+        if (!ego_mode || item == NULL || !item->is_node)
+          break;
+
+        int gr_nid = ego_to_base(ego_stub_to_local(item->node));
+        if (gr_nid != -1)
+          ego_expand(gr_nid);
+
+        // ignore the default double click handling
+        result = 1;
+        break;
+      }
+
       //
       // A group is being created
       //
@@ -705,12 +1328,25 @@ private:
       case grcode_user_refresh:
       {
         mutable_graph_t *mg = va_arg(va, mutable_graph_t *);
-        if (node_map.empty() || refresh_mode != gvrfm_soft)
+        bool rebuilt = node_map.empty() || refresh_mode != gvrfm_soft;
+        bool laid_out = false;
+        if (rebuilt)
         {
+          // Keep the view being left so switching back is instant
+          if (ego_mode)
+            drop_all_views();
+          else if (!node_map.empty() && refresh_mode != cur_view_mode)
+            stash_view(mg);
+          else
+            drop_view(gvrfm_combined_mode); // the groupping may have changed
+
           // Clear previous graph node data
           mg->clear();
           reset_states();
 
+          // Render the function's text once for all the nodes
+          render_func_text();
+
           mg->current_layout = options->graph_layout;
           mg->circle_center = point_t(200, 200);
           mg->circle_radius = 100;
@@ -720,15 +1356,38 @@ private:
           //       Otherwise it will screw up all the logic that rely on its value
           cur_view_mode = refresh_mode;
 
-          // Switch to the desired mode
-          if (refresh_mode == gvrfm_single_mode)
-            switch_to_single_view_mode(mg);
-          else if (refresh_mode == gvrfm_combined_mode)
-            switch_to_combined_view_mode(mg);
-          else
-            msg_unk_mode();
+          // Switch to the desired mode, unless it was kept aside
+          if (ego_mode || !restore_view(mg, &laid_out))
+          {
+            if (refresh_mode == gvrfm_single_mode)
+              switch_to_single_view_mode(mg);
+            else if (refresh_mode == gvrfm_combined_mode)
+              switch_to_combined_view_mode(mg);
+            else
+              msg_unk_mode();
+          }
+
+          // Size the selection / highlight for the new graph
+          selected_nodes.reset(int(node_map.size()));
+          highlighted_nodes.reset(int(node_map.size()));
+
+          // Keep the neighbourhood only
+          if (ego_mode)
+            ego_build_graph(mg, true);
+        }
+        else if (rsched.repaint_only)
+        {
+          // Only the colors or the texts changed: keep the layout
+          result = 1;
+          break;
         }
-        mg->redo_layout();
+        else if (ego_mode)
+        {
+          // The neighbourhood changed
+          ego_build_graph(mg, false);
+        }
+        if (!laid_out)
+          layout_graph(mg, rebuilt);
         result = 1;
         break;
       }
@@ -743,6 +1402,15 @@ private:
         const char **text  = va_arg(va, const char **);
         bgcolor_t *bgcolor = va_arg(va, bgcolor_t *);
 
+        // Stub nodes have no colors
+        if (ego_mode && node >= int(ego_nodes.size()))
+        {
+          *text = ego_stub_text[node - ego_nodes.size()].c_str();
+          result = 1;
+          break;
+        }
+        node = ego_to_base(node);
+
         // Retrieve the node text
         gnode_t *gnode = get_node(node);
         if (gnode == NULL)
@@ -751,21 +1419,16 @@ private:
           break;
         }
 
-        *text = gnode->text.c_str();
+        *text = gnode->get_text();
 
         // Caller requested a bgcolor?
         if (bgcolor != NULL) do
         {
           // Selection has priority over highlight
-          ncolormap_t::iterator psel = selected_nodes.find(node);
-          if (psel == selected_nodes.end())
-          {
-            psel = highlighted_nodes.find(node);
-            if (psel == highlighted_nodes.end())
-              break;
-          }
-          // Pass the color
-          *bgcolor = psel->second;
+          if (selected_nodes.has(node))
+            *bgcolor = selected_nodes.get_color(node);
+          else if (highlighted_nodes.has(node))
+            *bgcolor = highlighted_nodes.get_color(node);
         } while (false);
 
         result = 1;
@@ -783,17 +1446,26 @@ private:
         va_arg(va, int); // mouseedge_dst
         char **hint = va_arg(va, char **);
 
+        // Stub nodes hint
+        if (ego_mode && mousenode >= int(ego_nodes.size()))
+        {
+          *hint = qstrdup("Double click to expand");
+          result = 1;
+          break;
+        }
+        mousenode = ego_to_base(mousenode);
+
         // Get node data, aim for 'hint' field then 'text'
         gnode_t *node_data;
         if (     mousenode != -1
              && (node_data = get_node(mousenode)) != NULL )
         {
-          qstring *s = &node_data->hint;
-          if (s->empty())
-            s = &node_data->text;
-
           // 'hint' must be allocated by qalloc() or qstrdup()
-          *hint = qstrdup(s->c_str());
+          qstring group_hint;
+          if (get_group_hint(mousenode, node_data, &group_hint))
+            *hint = qstrdup(group_hint.c_str());
+          else
+            *hint = qstrdup(node_data->get_hint());
 
           // out: 0-use default hint, 1-use proposed hint
           result = 1;
@@ -806,6 +1478,15 @@ private:
       //
       case grcode_destroyed:
       {
+        cancel_refresh();
+
+        // Keep the nodes the user moved
+        if (gv != NULL)
+          save_layout(get_viewer_graph(gv));
+
+        if (options->debug)
+          dump_refresh_stats();
+
         gv = NULL;
         form = NULL;
 
@@ -828,15 +1509,18 @@ private:
     ng2id.clear();
 
     // Clear highlight / selected
-    highlighted_nodes.clear();
-    selected_nodes.clear();
+    highlighted_nodes.reset(0);
+    selected_nodes.reset(0);
 
     // Clear highlight / selection iterators
-    it_selected_node = selected_nodes.end();
-    it_highlighted_node = highlighted_nodes.end();
+    it_selected_node = -1;
+    it_highlighted_node = -1;
 
     // No node is selected
     cur_node = -1;
+
+    // Groups may have been added or removed
+    sg_index_dirty = true;
   }
 
   /**
@@ -864,7 +1548,217 @@ private:
     msg(STR_GS_MSG "Trigger again to '%s'\n", label);
   }
 
+  /**
+  * @brief Convert a shown node id to a whole graph node id (-1 for stub nodes)
+  */
+  inline int ego_to_base(int gvn)
+  {
+    if (!ego_mode)
+      return gvn;
+    return gvn < 0 || gvn >= int(ego_nodes.size()) ? -1 : ego_nodes[gvn];
+  }
+
+  /**
+  * @brief Return the owner of a stub node or the node itself
+  */
+  inline int ego_stub_to_local(int gvn)
+  {
+    int nstub = gvn - int(ego_nodes.size());
+    return nstub < 0 ? gvn : ego_stub_owner[nstub];
+  }
+
+  /**
+  * @brief Add the nodes around the given whole graph nodes to the shown nodes
+  *        (breadth first over the edges in both directions)
+  */
+  void ego_collect(const intvec_t &seeds)
+  {
+    intvec_t queue, dist;
+    for (size_t i=0; i < seeds.size(); i++)
+    {
+      int n = seeds[i];
+      if (n < 0 || n >= ego_base.size() || ego_local[n] != -1)
+        continue;
+      ego_local[n] = int(ego_nodes.size());
+      ego_nodes.push_back(n);
+      queue.push_back(n);
+      dist.push_back(0);
+    }
+
+    for (size_t head=0;
+         head < queue.size() && int(ego_nodes.size()) < options->ego_max_nodes;
+         head++)
+    {
+      int n = queue[head];
+      int d = dist[head];
+      if (d >= options->ego_hops)
+        continue;
+
+      for (int dir=0; dir < 2; dir++)
+      {
+        int count = dir == 0 ? ego_base.nsucc(n) : ego_base.npred(n);
+        for (int i=0; i < count && int(ego_nodes.size()) < options->ego_max_nodes; i++)
+        {
+          int m = dir == 0 ? ego_base.succ(n, i) : ego_base.pred(n, i);
+          if (ego_local[m] != -1)
+            continue;
+
+          ego_local[m] = int(ego_nodes.size());
+          ego_nodes.push_back(m);
+          queue.push_back(m);
+          dist.push_back(d + 1);
+        }
+      }
+    }
+  }
+
+  /**
+  * @brief Build the graph of the shown nodes with the stubs of the cut edges
+  * @param rebuild - the whole graph was just built into 'mg'
+  */
+  void ego_build_graph(mutable_graph_t *mg, bool rebuild)
+  {
+    if (rebuild)
+    {
+      // Remember the whole graph adjacency
+      intvec_t src, dst;
+      int count = mg->size();
+      for (int n=0; n < count; n++)
+      {
+        for (int i=0, nsucc=mg->nsucc(n); i < nsucc; i++)
+        {
+          src.push_back(n);
+          dst.push_back(mg->succ(n, i));
+        }
+      }
+      ego_base.build(count, src, dst);
+
+      // Start again from the seeds
+      ego_nodes.qclear();
+      ego_local.qclear();
+      ego_local.resize(count, -1);
+
+      intvec_t seeds;
+      for (size_t i=0; i < ego_seed_nids.size(); i++)
+        seeds.push_back(get_gvnid_from_nid(ego_seed_nids[i]));
+      ego_collect(seeds);
+
+      // Fallback to the entry node
+      if (ego_nodes.empty() && count > 0)
+      {
+        seeds.qclear();
+        seeds.push_back(0);
+        ego_collect(seeds);
+      }
+    }
+
+    ego_stub_owner.qclear();
+    ego_stub_text.qclear();
+
+    // Count the cut edges of each shown node
+    int nshown = int(ego_nodes.size());
+    intvec_t cut_out, cut_in;
+    cut_out.resize(nshown, 0);
+    cut_in.resize(nshown, 0);
+    for (int i=0; i < nshown; i++)
+    {
+      int n = ego_nodes[i];
+      for (int j=0, nsucc=ego_base.nsucc(n); j < nsucc; j++)
+      {
+        if (ego_local[ego_base.succ(n, j)] == -1)
+          ++cut_out[i];
+      }
+      for (int j=0, npred=ego_base.npred(n); j < npred; j++)
+      {
+        if (ego_local[ego_base.pred(n, j)] == -1)
+          ++cut_in[i];
+      }
+      if (cut_out[i] > 0)
+      {
+        ego_stub_owner.push_back(i);
+        ego_stub_text.push_back().sprnt("%d more...", cut_out[i]);
+      }
+      if (cut_in[i] > 0)
+      {
+        ego_stub_owner.push_back(i);
+        ego_stub_text.push_back().sprnt("...%d more", cut_in[i]);
+      }
+    }
+
+    mg->clear();
+    mg->resize(nshown + int(ego_stub_owner.size()));
+
+    int stub = nshown;
+    for (int i=0; i < nshown; i++)
+    {
+      int n = ego_nodes[i];
+      for (int j=0, nsucc=ego_base.nsucc(n); j < nsucc; j++)
+      {
+        int m = ego_local[ego_base.succ(n, j)];
+        if (m != -1)
+          mg->add_edge(i, m, NULL);
+      }
+      if (cut_out[i] > 0)
+        mg->add_edge(i, stub++, NULL);
+      if (cut_in[i] > 0)
+        mg->add_edge(stub++, i, NULL);
+    }
+  }
+
+  /**
+  * @brief Grow the shown nodes around a whole graph node. Start over when there is
+  *        no more room
+  */
+  void ego_expand(int gr_nid)
+  {
+    intvec_t seeds;
+    seeds.push_back(gr_nid);
+
+    // Remember a flowchart node of it so the view survives a rebuild
+    int nid = gr_nid;
+    if (cur_view_mode == gvrfm_combined_mode)
+    {
+      pnodegroup_t ng = get_ng_from_ngid(gr_nid);
+      pnodedef_t nd = ng == NULL ? NULL : ng->get_first_node();
+      nid = nd == NULL ? -1 : nd->nid;
+    }
+
+    if (int(ego_nodes.size()) >= options->ego_max_nodes)
+    {
+      ego_nodes.qclear();
+      ego_local.qclear();
+      ego_local.resize(ego_base.size(), -1);
+      ego_seed_nids.qclear();
+    }
+    if (nid != -1)
+      ego_seed_nids.push_back(nid);
+
+    ego_collect(seeds);
+
+    // Only rebuild the shown graph. The caller jumps to the new nodes: do it now
+    redo_layout(gvrfm_soft);
+    flush_refresh();
+  }
+
 public:
+  /**
+  * @brief Focuses and jumps to a whole graph node. In neighbourhood view,
+  *        the shown nodes grow to include it
+  */
+  void jump_to_gvnode(int gr_nid)
+  {
+    if (ego_mode)
+    {
+      if (gr_nid < 0 || gr_nid >= int(ego_local.size()))
+        return;
+      if (ego_local[gr_nid] == -1)
+        ego_expand(gr_nid);
+      gr_nid = ego_local[gr_nid];
+      if (gr_nid == -1)
+        return;
+    }
+    jump_to_node(gv, gr_nid);
+  }
 
   /**
   * @brief Return graph view node id from an actual node id
@@ -966,7 +1860,7 @@ public:
   void clear_selection(bool delay_refresh)
   {
     selected_nodes.clear();
-    it_selected_node = selected_nodes.end();
+    it_selected_node = -1;
     if (!delay_refresh)
       refresh_view();
   }
@@ -977,7 +1871,7 @@ public:
   void clear_highlighting(bool delay_refresh)
   {
     highlighted_nodes.clear();
-    it_highlighted_node = highlighted_nodes.end();
+    it_highlighted_node = -1;
     if (!delay_refresh)
       refresh_view();
   }
@@ -1002,7 +1896,7 @@ public:
       if (delay_refresh)
         newly_colored.insert(gr_nid);
 
-      highlighted_nodes[gr_nid] = clr;
+      highlighted_nodes.set(gr_nid, clr);
     }
     // Single view mode?
     else if (cur_view_mode == gvrfm_single_mode)
@@ -1017,7 +1911,7 @@ public:
         if (delay_refresh)
           newly_colored.insert(nid);
 
-        highlighted_nodes[nid] = clr;
+        highlighted_nodes.set(nid, clr);
       }
     }
     // Unknown mode
@@ -1068,22 +1962,22 @@ public:
 
   /**
   * @brief Highlight a nodegroup list
+  * @param color_key - palette key of the color shared by the node groups
   */
   void highlight_nodes(
           pnodegroup_list_t ngl,
-          colorgen_t &cg,
+          unsigned int color_key,
           bool delay_refresh)
   {
-    // Use one color for all the different group defs
-    colorvargen_t cv;
-    cg.get_colorvar(cv);
+    const colorpalette_t &palette = colorpalette_t::instance();
 
+    unsigned int shade = 0;
     for (nodegroup_list_t::iterator it=ngl->begin();
          it != ngl->end();
          ++it)
     {
-      // Use a new color variant for each node group
-      bgcolor_t clr = cg.get_color_anyway(cv);
+      // Use a new shade of the color for each node group
+      bgcolor_t clr = palette.get_color(color_key, shade++);
       pnodegroup_t ng = *it;
 
       // Always call with delayed refresh mode in the inner loop
@@ -1103,10 +1997,9 @@ public:
   */
   void highlight_nodes(
     psupergroup_listp_t groups,
-    colorgen_t &cg,
     bool delay_refresh)
   {
-    colorvargen_t cv;
+    qvector<psupergroup_t> sgs;
     for (supergroup_listp_t::iterator it=groups->begin();
          it != groups->end();
          ++it)
@@ -1122,23 +2015,19 @@ public:
         // Don't highlight syntethic super groups
         continue;
       }
+      sgs.push_back(sg);
+    }
 
-      // Assign a new color variant for each group
-      cg.get_colorvar(cv);
-      for (nodegroup_list_t::iterator it=sg->groups.begin();
-           it != sg->groups.end();
-           ++it)
-      {
-        // Use a new color variant for each group
-        bgcolor_t clr = cg.get_color_anyway(cv);
-        pnodegroup_t ng = *it;
-
-        // Always call with lazy mode in the inner loop
-        highlight_nodes(
-            ng,
-            clr,
-            true);
-      }
+    // The super groups highlighted together get distinct colors
+    std::sort(sgs.begin(), sgs.end(), sg_color_less_t());
+    colorslots_t slots;
+    for (size_t i=0; i < sgs.size(); i++)
+    {
+      // Each super group has its own color
+      highlight_nodes(
+          &sgs[i]->groups,
+          slots.get_key(get_sg_color_key(sgs[i])),
+          true);
     }
 
     // Since we were called with delayed refresh mode, now see if refresh is needed
@@ -1160,19 +2049,17 @@ public:
       return;
     }
 
-    // Convert selected nodes map to an intvec
+    // Convert selected nodes set to an intvec
     intvec_t sel_nodes;
-    for (ncolormap_t::iterator it=selected_nodes.begin();
-         it != selected_nodes.end();
-         ++it)
-    {
-      sel_nodes.push_back(it->first);
-    }
+    for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
+      sel_nodes.push_back(nid);
 
     pnodegroup_list_t ngl = actions->find_similar(sel_nodes);
 
-    DECL_CG;
-    highlight_nodes(ngl, cg, options->manual_refresh_mode);
+    highlight_nodes(
+      ngl,
+      colorpalette_t::hash_int(sel_nodes[0]),
+      options->manual_refresh_mode);
     ngl->free_nodegroup(false);
     delete ngl;
   }
@@ -1182,13 +2069,8 @@ public:
   */
   void select_all_nodes()
   {
-    selected_nodes.clear();
-    for (nid2ndef_t::iterator it = gm->get_nds()->begin();
-         it != gm->get_nds()->end();
-         ++it)
-    {
-      selected_nodes[it->second->nid] = NODE_SEL_COLOR;
-    }
+    // Select all the nodes of the current view
+    selected_nodes.set_all(int(node_map.size()), NODE_SEL_COLOR);
   }
 
   /**
@@ -1198,11 +2080,10 @@ public:
           int cur_node,
           bool delay_refresh)
   {
-    ncolormap_t::iterator p = selected_nodes.find(cur_node);
-    if (p == selected_nodes.end())
-      selected_nodes[cur_node] = NODE_SEL_COLOR;
+    if (!selected_nodes.has(cur_node))
+      selected_nodes.set(cur_node, NODE_SEL_COLOR);
     else
-      selected_nodes.erase(p);
+      selected_nodes.erase(cur_node);
 
     // With quick selection mode, just display a message and don't force a refresh
     if (delay_refresh)
@@ -1217,7 +2098,89 @@ public:
   }
 
   /**
-  * @brief Find and highlights nodes
+  * @brief Return the text indexed for a super group
+  */
+  static void get_sg_doc_text(psupergroup_t sg, qstring *text)
+  {
+    *text = sg->name;
+    text->append('\n');
+    text->append(sg->id);
+  }
+
+  /**
+  * @brief Update the search index of a renamed super group
+  */
+  void update_sg_search_index(psupergroup_t sg)
+  {
+    if (sg_index_dirty)
+      return;
+
+    std::map<psupergroup_t, int>::iterator it = sg_doc_ids.find(sg);
+    if (it == sg_doc_ids.end())
+    {
+      sg_index_dirty = true;
+      return;
+    }
+
+    qstring text;
+    get_sg_doc_text(sg, &text);
+    sg_index.set_doc(it->second, text.c_str());
+  }
+
+  /**
+  * @brief Build the search indices if they are out of date
+  */
+  void ensure_search_index()
+  {
+    if (sg_index_dirty)
+    {
+      sg_index.clear();
+      sg_docs.qclear();
+      sg_doc_ids.clear();
+
+      qstring text;
+      psupergroup_listp_t sgroups = gm->get_path_sgl();
+      for (supergroup_listp_t::iterator it=sgroups->begin();
+           it != sgroups->end();
+           ++it)
+      {
+        psupergroup_t sg = *it;
+        int id = int(sg_docs.size());
+        sg_docs.push_back(sg);
+        sg_doc_ids[sg] = id;
+
+        get_sg_doc_text(sg, &text);
+        sg_index.set_doc(id, text.c_str());
+      }
+      sg_index_dirty = false;
+    }
+
+    // The node texts only change with the function
+    uint32 counter = fccache_t::instance()->get_change_counter();
+    if (    func_fc != NULL
+         && (    node_index_ea != func_fc->bounds.startEA
+              || node_index_size != func_text.size()
+              || node_index_counter != counter))
+    {
+      node_index.clear();
+
+      qvector<char> buf;
+      for (int n=0, count=func_text.size(); n < count; n++)
+      {
+        // Search the text without the color tags
+        buf.resize(func_text.get_length(n) + 1);
+        tag_remove(func_text.get_text(n), &buf[0], buf.size());
+        node_index.set_doc(n, &buf[0]);
+      }
+      node_index_ea = func_fc->bounds.startEA;
+      node_index_size = func_text.size();
+      node_index_counter = counter;
+    }
+  }
+
+  /**
+  * @brief Find and highlights nodes. The pattern is matched against the super group
+  *        names and ids and the node texts. A pattern enclosed in '/' is a regular expression
   */
   void find_and_highlight_nodes(bool delay_refresh)
   {
@@ -1233,48 +2196,87 @@ public:
         pattern,
         sizeof(last_pattern));
 
-    DECL_CG;
+    qstring query = pattern;
+    size_t len = query.length();
+    bool regex = len > 2 && query[0] == '/' && query[len - 1] == '/';
+    if (regex)
+      query = query.substr(1, len - 1);
+
+    ensure_search_index();
+
+    intvec_t sg_ids, node_ids;
+    if (    !sg_index.find(query.c_str(), regex, sg_ids)
+         || !node_index.find(query.c_str(), regex, node_ids))
+    {
+      warning("Invalid regular expression: %s", query.c_str());
+      return;
+    }
 
     clear_highlighting(true);
 
-    pnodegroup_list_t groups = NULL;
+    int first_nid = -1;
 
-    // Walk all the groups
-    psupergroup_listp_t sgroups = gm->get_path_sgl();
-    for (supergroup_listp_t::iterator it=sgroups->begin();
-         it != sgroups->end();
-         ++it)
+    // Jump to the first matching super group
+    qvector<psupergroup_t> sgs;
+    for (size_t i=0; i < sg_ids.size(); i++)
     {
-      psupergroup_t sg = *it;
-      if (    stristr(sg->name.c_str(), pattern) != NULL
-           || stristr(sg->id.c_str(), pattern) != NULL )
+      psupergroup_t sg = sg_docs[sg_ids[i]];
+      sgs.push_back(sg);
+
+      if (first_nid == -1)
       {
-        groups = &sg->groups;
-        highlight_nodes(
-          groups,
-          cg,
-          true);
+        pnodegroup_t ng = sg->groups.get_first_ng();
+        if (ng != NULL)
+          first_nid = get_ngid_from_ng(ng);
       }
     }
 
+    // Highlight the matching super groups, each with a distinct color
+    std::sort(sgs.begin(), sgs.end(), sg_color_less_t());
+    colorslots_t slots;
+    for (size_t i=0; i < sgs.size(); i++)
+    {
+      highlight_nodes(
+        &sgs[i]->groups,
+        slots.get_key(get_sg_color_key(sgs[i])),
+        true);
+    }
+
+    // Highlight the nodes whose text matches
+    bgcolor_t clr = colorpalette_t::instance().get_color(
+        slots.get_key(colorpalette_t::hash_str(query.c_str())),
+        0);
+    for (size_t i=0; i < node_ids.size(); i++)
+    {
+      int gv_nid = get_gvnid_from_nid(node_ids[i]);
+      if (gv_nid == -1 || highlighted_nodes.has(gv_nid))
+        continue;
+
+      highlighted_nodes.set(gv_nid, clr);
+      if (first_nid == -1)
+        first_nid = gv_nid;
+    }
+
+    if (options->debug)
+    {
+      msg(STR_GS_MSG "Search '%s': %d group(s), %d node(s), cache %u hits %u misses\n",
+        query.c_str(),
+        int(sg_ids.size()),
+        int(node_ids.size()),
+        sg_index.get_cache_hits() + node_index.get_cache_hits(),
+        sg_index.get_cache_misses() + node_index.get_cache_misses());
+    }
+
     // Refresh graph if at least there is one match
     if (!delay_refresh)
-	{
+    {
       refresh_view();
-      if (groups == NULL)
+      if (first_nid == -1)
         return;
-	}
-
-    int nid;
-    pnodegroup_t ng = groups->get_first_ng();
-    nid = ng == NULL ? -1 : get_ngid_from_ng(ng);
-
-    if (nid != -1)
-    {
-      jump_to_node(
-        gv,
-        nid);
     }
+
+    if (first_nid != -1)
+      jump_to_gvnode(first_nid);
   }
 
   /**
@@ -1282,35 +2284,23 @@ public:
   */
   void merge_highlight_with_selection()
   {
-    for (ncolormap_t::iterator it=highlighted_nodes.begin();
-         it != highlighted_nodes.end();
-         ++it)
-    {
-      if (selected_nodes.find(it->first) != selected_nodes.end())
-        continue;
-      else
-      {
-        selected_nodes[it->first] = NODE_SEL_COLOR;
-      }
-    }
+    selected_nodes.merge(highlighted_nodes, NODE_SEL_COLOR);
   }
 
   /**
   * @brief Jumps to next item in the container
   */
-  void jump_to_next_node(ncolormap_t::iterator &it, ncolormap_t &cont)
+  void jump_to_next_node(int &it, ncolorset_t &cont)
   {
     if (cont.empty())
       return;
 
-    // End? Rewind
-    if (it == cont.end())
-      it = cont.begin();
-
-    jump_to_node(gv, it->first);
+    // Advance to next match. End? Rewind
+    it = cont.next(it);
+    if (it == -1)
+      it = cont.first();
 
-    // Advance to next match
-    ++it;
+    jump_to_gvnode(it);
   }
 
   /**
@@ -1325,12 +2315,10 @@ public:
       // Make a nodegroup list from the selection
       //
       nodegroup_list_t ngl;
-      for (ncolormap_t::iterator it = selected_nodes.begin();
-           it != selected_nodes.end();
-           ++it)
+      for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
       {
         // Get the other selected NG
-        pnodegroup_t ng = get_ng_from_ngid(it->first);
+        pnodegroup_t ng = get_ng_from_ngid(nid);
         ngl.push_back(ng);
       }
 
@@ -1340,12 +2328,10 @@ public:
     else if (cur_view_mode == gvrfm_single_mode)
     {
       nodegroup_t ng;
-      for (ncolormap_t::iterator it = selected_nodes.begin();
-           it != selected_nodes.end();
-           ++it)
+      for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
       {
         // Find node structure
-        nodeloc_t *loc = gm->find_nodeid_loc(it->first);
+        nodeloc_t *loc = gm->find_nodeid_loc(nid);
         if (loc == NULL)
         {
           msg_err_node_not_found();
@@ -1384,13 +2370,11 @@ public:
     std::map<pnodegroup_t, psupergroup_t> found_ng;
     pnodegroup_t  ng;
     psupergroup_t sg;
-    for (ncolormap_t::iterator it=selected_nodes.begin();
-         it != selected_nodes.end();
-         ++it)
+    for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
     {
       if (cur_view_mode == gvrfm_single_mode)
       {
-        nodeloc_t *loc = gm->find_nodeid_loc(it->first);
+        nodeloc_t *loc = gm->find_nodeid_loc(nid);
         if (loc == NULL)
         {
           msg_err_node_not_found();
@@ -1401,7 +2385,7 @@ public:
       }
       else if (cur_view_mode == gvrfm_combined_mode)
       {
-        ng = get_ng_from_ngid(it->first);
+        ng = get_ng_from_ngid(nid);
         if (ng == NULL)
           continue;
         sg = get_sg_from_ng(ng);
@@ -1430,11 +2414,13 @@ public:
 
       // Remove NG from the current SG
       sg->remove_nodegroup(ng, false);
+      gm->notify_sg_changed(sg);
 
       // Make a new SG
       psupergroup_t new_sg = gm->add_supergroup(gm->get_path_sgl());
       new_sg->copy_attr_from(sg);
       new_sg->add_nodegroup(ng);
+      gm->notify_sg_changed(new_sg);
 
       // Allow the user to edit the new SG
       edit_sg_description(new_sg);
@@ -1468,11 +2454,9 @@ public:
     {
       // For each ND, directly take it out from its parent NG and put it in its own NG in the same SG
       // If the NG have one node and this node is self, then do nothing
-      for (ncolormap_t::iterator it = selected_nodes.begin();
-           it != selected_nodes.end();
-           ++it)
+      for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
       {
-        nodeloc_t *loc = gm->find_nodeid_loc(it->first);
+        nodeloc_t *loc = gm->find_nodeid_loc(nid);
         if (loc == NULL)
         {
           msg_err_node_not_found();
@@ -1487,6 +2471,7 @@ public:
 
         // Create a new node group in the SG and add the node to it
         loc->sg->add_nodegroup()->add_node(loc->nd);
+        gm->notify_sg_changed(loc->sg);
 
         // Remember a focus node
         focus_node = loc->nd->nid;
@@ -1496,12 +2481,10 @@ public:
     {
       // In combined mode, each node is an NG
       // Take each node out of the NG and put in the NG's SG
-      for (ncolormap_t::iterator it = selected_nodes.begin();
-           it != selected_nodes.end();
-           ++it)
+      for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
       {
         // Get the select NG
-        pnodegroup_t ng = get_ng_from_ngid(it->first);
+        pnodegroup_t ng = get_ng_from_ngid(nid);
         if (ng == NULL || ng->size() == 1)
           continue;
 
@@ -1516,86 +2499,563 @@ public:
         if (sg == NULL)
           continue;
 
-        // Take out each ND in this NG
-        while (ng->size() > 1)
-        {
-          nd = ng->back();
-          ng->pop_back();
+        // Take out each ND in this NG
+        while (ng->size() > 1)
+        {
+          nd = ng->back();
+          ng->pop_back();
+
+          sg->add_nodegroup()->add_node(nd);
+
+          // Remember a focus node
+          focus_node = nd->nid;
+        }
+        gm->notify_sg_changed(sg);
+      }
+    }
+
+    // Reinitialize lookup tables
+    gm->initialize_lookups();
+
+    // Refresh the chooser; no need to re-do layout though
+    actions->notify_refresh(true);
+
+    // Re-layout
+    redo_current_layout();
+  }
+
+  /**
+  * @brief Return the node ids the actions apply to: the selected nodes
+  *        or the current node
+  */
+  bool get_action_nids(intvec_t &nids)
+  {
+    intvec_t gr_nids;
+    if (!selected_nodes.empty())
+    {
+      for (int nid=selected_nodes.first(); nid != -1; nid=selected_nodes.next(nid))
+      {
+        gr_nids.push_back(nid);
+      }
+    }
+    else if (cur_node != -1)
+    {
+      gr_nids.push_back(cur_node);
+    }
+
+    for (size_t i=0; i < gr_nids.size(); i++)
+    {
+      int nid = gr_nids[i];
+      if (cur_view_mode == gvrfm_combined_mode)
+      {
+        // In combined mode, take the first node of the NG
+        pnodegroup_t ng = get_ng_from_ngid(nid);
+        pnodedef_t nd = ng == NULL ? NULL : ng->get_first_node();
+        if (nd == NULL)
+          continue;
+        nid = nd->nid;
+      }
+      nids.push_back(nid);
+    }
+    return !nids.empty();
+  }
+
+  /**
+  * @brief Compute the loop nesting forest of the current function
+  */
+  bool build_loops(loopforest_t &lf)
+  {
+    fcgraph_t tmp;
+    const fcgraph_t &g = fccache_t::instance()->get_graph(*func_fc, tmp);
+
+    dominators_t doms;
+    return doms.build(g) && lf.build(doms);
+  }
+
+  /**
+  * @brief Checks if all the nodes of a loop are in the given node group
+  */
+  bool is_loop_in_ng(
+      const loopforest_t &lf,
+      int l,
+      pnodegroup_t ng)
+  {
+    intvec_t nodes;
+    lf.get_loop_nodes(l, nodes);
+    for (size_t i=0; i < nodes.size(); i++)
+    {
+      nodeloc_t *loc = gm->find_nodeid_loc(nodes[i]);
+      if (loc == NULL || loc->ng != ng)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+  * @brief Collapse the innermost loop that is not already collapsed into one node group
+  */
+  void collapse_loops(const intvec_t &nids)
+  {
+    loopforest_t lf;
+    if (!build_loops(lf))
+      return;
+
+    for (size_t i=0; i < nids.size(); i++)
+    {
+      int nid = nids[i];
+      nodeloc_t *loc = gm->find_nodeid_loc(nid);
+      if (loc == NULL)
+      {
+        msg_err_node_not_found(nid);
+        continue;
+      }
+
+      // Find the innermost loop that is not collapsed yet
+      int l = lf.get_node_loop(nid);
+      while (l != -1 && is_loop_in_ng(lf, l, loc->ng))
+        l = lf[l].parent;
+
+      if (l == -1)
+      {
+        msg(STR_GS_MSG "Node %d is not in a loop that can be collapsed\n", nid);
+        continue;
+      }
+
+      // Move the loop nodes to a single NG; the header comes first
+      intvec_t nodes;
+      lf.get_loop_nodes(l, nodes);
+
+      nodegroup_t ng;
+      for (size_t j=0; j < nodes.size(); j++)
+      {
+        nodeloc_t *nloc = gm->find_nodeid_loc(nodes[j]);
+        if (nloc != NULL)
+          ng.add_node(nloc->nd);
+      }
+      gm->move_nodes_to_ng(&ng);
+
+      focus_node = lf[l].header;
+    }
+
+    // Refresh the chooser
+    actions->notify_refresh(true);
+
+    // Re-layout
+    redo_current_layout();
+  }
+
+  /**
+  * @brief Expand the outermost collapsed loop: its nested loops are
+  *        collapsed and its other nodes are moved to their own NG
+  */
+  void expand_loops(const intvec_t &nids)
+  {
+    loopforest_t lf;
+    if (!build_loops(lf))
+      return;
+
+    for (size_t i=0; i < nids.size(); i++)
+    {
+      int nid = nids[i];
+      nodeloc_t *loc = gm->find_nodeid_loc(nid);
+      if (loc == NULL)
+      {
+        msg_err_node_not_found(nid);
+        continue;
+      }
+      pnodegroup_t ng = loc->ng;
+      psupergroup_t sg = loc->sg;
+
+      // Find the outermost loop collapsed in the node's NG
+      int l = lf.get_node_loop(nid);
+      if (l == -1 || !is_loop_in_ng(lf, l, ng))
+      {
+        msg(STR_GS_MSG "Node %d is not in a collapsed loop\n", nid);
+        continue;
+      }
+      while (lf[l].parent != -1 && is_loop_in_ng(lf, lf[l].parent, ng))
+        l = lf[l].parent;
+
+      const loop_t &loop = lf[l];
+
+      // Each nested loop gets its own NG
+      for (size_t j=0; j < loop.children.size(); j++)
+      {
+        intvec_t nodes;
+        lf.get_loop_nodes(loop.children[j], nodes);
+
+        pnodegroup_t child_ng = sg->add_nodegroup();
+        for (size_t k=0; k < nodes.size(); k++)
+        {
+          pnodedef_t nd = gm->find_nodeid_loc(nodes[k])->nd;
+          ng->remove(nd);
+          child_ng->add_node(nd);
+        }
+      }
+
+      // Each remaining node of the loop gets its own NG
+      for (size_t j=0; j < loop.nodes.size(); j++)
+      {
+        pnodedef_t nd = gm->find_nodeid_loc(loop.nodes[j])->nd;
+        ng->remove(nd);
+        sg->add_nodegroup()->add_node(nd);
+      }
+
+      if (ng->empty())
+        sg->remove_nodegroup(ng, true);
+      gm->notify_sg_changed(sg);
+
+      // Reinitialize lookup tables
+      gm->initialize_lookups();
+
+      focus_node = loop.header;
+    }
+
+    // Refresh the chooser
+    actions->notify_refresh(true);
+
+    // Re-layout
+    redo_current_layout();
+  }
+
+  /**
+  * @brief Edit the description of a super group
+  */
+  bool edit_sg_description(psupergroup_t sg)
+  {
+    const char *desc;
+
+    while (true)
+    {
+      desc = askstr(
+        HIST_CMT,
+        sg->get_display_name(STR_DUMMY_SG_NAME),
+        "Please enter new description");
+
+      if (desc == NULL)
+        return false;
+
+      if (   strchr(desc, ')') != NULL
+          || strchr(desc, '(') != NULL
+          || strchr(desc, ':') != NULL
+          || strchr(desc, ';') != NULL)
+      {
+        warning("The name cannot contain the following characters: '();:'");
+        continue;
+      }
+      break;
+    }
+
+    // Adjust the name
+    sg->name = desc;
+    gm->notify_sg_changed(sg);
+    update_sg_search_index(sg);
+
+    // From the super group, get all individual node groups
+    for (nodegroup_list_t::iterator it=sg->groups.begin();
+         it != sg->groups.end();
+         ++it)
+    {
+      // Get the group node id from the node group reference
+      pnodegroup_t ng = *it;
+      int ngid = get_ngid_from_ng(ng);
+      if (ngid == -1)
+        continue;
+
+      gnode_t *gnode = get_node(ngid);
+      if (gnode == NULL)
+        continue;;
+
+      // Update the node display text
+      // TODO: PERFORMANCE: can you have gnode link to a groupman related structure and pull its
+      //                    text dynamically?
+      gnode->text = sg->get_display_name();
+    }
+
+    // Keep the buffered combined view in sync
+    viewbuf_t &vb = get_viewbuf(gvrfm_combined_mode);
+    if (vb.valid)
+    {
+      for (nodegroup_list_t::iterator it=sg->groups.begin();
+           it != sg->groups.end();
+           ++it)
+      {
+        gnode_t *gnode = vb.node_map.get(vb.ng2id.get_ng_id(*it));
+        if (gnode == NULL)
+          continue;
+
+        gnode->text = sg->get_display_name();
+        vb.relayout = true;
+      }
+    }
+
+    if (!options->manual_refresh_mode)
+      schedule_refresh(RFD_TEXT);
+
+    return true;
+  }
+
+  /**
+  * @brief Build the hint of a groupped node of the combined view
+  * @return False if the node has its own hint
+  */
+  bool get_group_hint(
+      int ngid,
+      gnode_t *gnode,
+      qstring *out)
+  {
+    if (    cur_view_mode != gvrfm_combined_mode
+         || !gnode->hint.empty()
+         || gnode->text_ref != NULL)
+    {
+      return false;
+    }
+
+    pnodegroup_t ng = get_ng_from_ngid(ngid);
+    if (ng == NULL || ng->size() <= 1)
+      return false;
+
+    intvec_t nids;
+    for (nodegroup_t::iterator it=ng->begin(); it != ng->end(); ++it)
+      nids.push_back((*it)->nid);
+    std::sort(nids.begin(), nids.end());
+
+    // The group name is not cached: it may be renamed
+    nodeloc_t *loc = gm->find_nodeid_loc(nids[0]);
+    if (loc != NULL)
+      out->sprnt("%s\n", loc->sg->get_display_name(STR_DUMMY_SG_NAME));
+
+    out->append(hintcache_t::instance()->get_hint(
+        *func_fc,
+        func_text,
+        func_text_counter,
+        nids,
+        options->hint_max_lines));
+    return true;
+  }
+
+  /**
+  * @brief Return the buffer of a view mode
+  */
+  inline viewbuf_t &get_viewbuf(gvrefresh_modes_e mode)
+  {
+    return viewbufs[mode == gvrfm_single_mode ? 0 : 1];
+  }
+
+  /**
+  * @brief Drop the buffered view of a mode
+  */
+  void drop_view(gvrefresh_modes_e mode)
+  {
+    viewbuf_t &vb = get_viewbuf(mode);
+    vb.node_map.clear();
+    vb.ng2id.clear();
+    vb.layout.clear();
+    vb.mem = 0;
+    vb.valid = vb.relayout = false;
+  }
+
+  void drop_all_views()
+  {
+    drop_view(gvrfm_single_mode);
+    drop_view(gvrfm_combined_mode);
+  }
+
+  /**
+  * @brief Render the function text unless it is current. The buffered views
+  *        point into it so they are dropped when it is rendered again
+  */
+  void render_func_text()
+  {
+    uint32 counter = fccache_t::instance()->get_change_counter();
+    if (    func_text_ea == func_fc->bounds.startEA
+         && func_text_size == func_fc->size()
+         && func_text_counter == counter)
+    {
+      return;
+    }
+
+    drop_all_views();
+    func_text.build(*func_fc);
+
+    func_text_ea = func_fc->bounds.startEA;
+    func_text_size = func_fc->size();
+    func_text_counter = counter;
+  }
+
+  /**
+  * @brief Move the current view with its layout aside
+  */
+  void stash_view(mutable_graph_t *mg)
+  {
+    drop_view(cur_view_mode);
+    viewbuf_t &vb = get_viewbuf(cur_view_mode);
+
+    gvmembers_t members;
+    gvtexts_t texts;
+    get_node_members(mg, members, texts);
+    vb.layout.capture(mg, members, texts);
+
+    vb.node_map.swap(node_map);
+    vb.ng2id.swap(ng2id);
+
+    vb.mem =   vb.node_map.memory_usage()
+             + vb.layout.memory_usage()
+             + vb.ng2id.size() * (sizeof(pnodegroup_t) + sizeof(int));
+
+    // Huge functions do not keep the inactive view
+    if (    options->view_buffer_max_bytes != 0
+         && vb.mem > size_t(options->view_buffer_max_bytes))
+    {
+      if (options->debug)
+        msg(STR_GS_MSG "Inactive view too big to keep (%u KB)\n", uint32(vb.mem / 1024));
+      drop_view(cur_view_mode);
+      return;
+    }
+    vb.valid = true;
+  }
+
+  /**
+  * @brief Show the buffered view of the current mode
+  * @param laid_out - set if the saved layout was restored
+  * @return False if the mode has no buffered view
+  */
+  bool restore_view(
+      mutable_graph_t *mg,
+      bool *laid_out)
+  {
+    viewbuf_t &vb = get_viewbuf(cur_view_mode);
+    if (!vb.valid)
+      return false;
 
-          sg->add_nodegroup()->add_node(nd);
+    node_map.swap(vb.node_map);
+    ng2id.swap(vb.ng2id);
 
-          // Remember a focus node
-          focus_node = nd->nid;
-        }
-      }
-    }
+    layout_type_t layout = mg->current_layout;
+    vb.layout.build_graph(mg);
+    mg->current_layout = layout;
 
-    // Reinitialize lookup tables
-    gm->initialize_lookups();
+    gvmembers_t members;
+    gvtexts_t texts;
+    get_node_members(mg, members, texts);
+    *laid_out = vb.layout.apply(mg, members, texts);
 
-    // Refresh the chooser; no need to re-do layout though
-    actions->notify_refresh(true);
+    // Node texts changed while the view was inactive: relayout around the old positions
+    if (*laid_out && vb.relayout)
+      layout_graph(mg, false);
 
-    // Re-layout
-    redo_current_layout();
+    drop_view(cur_view_mode);
+    return true;
   }
 
   /**
-  * @brief Edit the description of a super group
+  * @brief Return the node ids shown by each graph node and the hash of its text
   */
-  bool edit_sg_description(psupergroup_t sg)
+  void get_node_members(
+      mutable_graph_t *mg,
+      gvmembers_t &members,
+      gvtexts_t &texts)
   {
-    const char *desc;
-
-    while (true)
+    texts.qclear();
+    texts.resize(mg->size(), 0);
+    for (size_t n=0; n < texts.size(); n++)
     {
-      desc = askstr(
-        HIST_CMT,
-        sg->get_display_name(STR_DUMMY_SG_NAME),
-        "Please enter new description");
+      gnode_t *gnode = node_map.get(int(n));
+      if (gnode != NULL)
+        texts[n] = gvlayout_t::hash_text(gnode->get_text());
+    }
 
-      if (desc == NULL)
-        return false;
+    members.qclear();
+    members.resize(mg->size());
+    if (cur_view_mode == gvrfm_single_mode)
+    {
+      for (size_t n=0; n < members.size(); n++)
+        members[n].push_back(int(n));
+      return;
+    }
 
-      if (   strchr(desc, ')') != NULL
-          || strchr(desc, '(') != NULL
-          || strchr(desc, ':') != NULL
-          || strchr(desc, ';') != NULL)
-      {
-        warning("The name cannot contain the following characters: '();:'");
+    for (ng2nid_t::iterator it=ng2id.begin(); it != ng2id.end(); ++it)
+    {
+      int ngid = it->second;
+      if (ngid < 0 || size_t(ngid) >= members.size())
         continue;
-      }
-      break;
+
+      intvec_t &m = members[ngid];
+      pnodegroup_t ng = it->first;
+      for (nodegroup_t::iterator it_nd=ng->begin(); it_nd != ng->end(); ++it_nd)
+        m.push_back((*it_nd)->nid);
+      std::sort(m.begin(), m.end());
     }
+  }
 
-    // Adjust the name
-    sg->name = desc;
+  /**
+  * @brief Return the database tag of the layout of the current view mode
+  */
+  inline char get_layout_tag() const
+  {
+    return cur_view_mode == gvrfm_single_mode ? 'S' : 'C';
+  }
 
-    // From the super group, get all individual node groups
-    for (nodegroup_list_t::iterator it=sg->groups.begin();
-         it != sg->groups.end();
-         ++it)
+  /**
+  * @brief Save the current layout of the graph
+  */
+  void save_layout(mutable_graph_t *mg)
+  {
+    if (mg == NULL || ego_mode || !options->persist_layout || node_map.empty())
+      return;
+
+    gvmembers_t members;
+    gvtexts_t texts;
+    get_node_members(mg, members, texts);
+
+    gvlayout_t layout;
+    layout.capture(mg, members, texts);
+    layout.save(func_fc->bounds.startEA, get_layout_tag());
+  }
+
+  /**
+  * @brief Lay out the graph. A rebuilt graph reuses its saved layout if it did not
+  *        change; otherwise the previous layout seeds the new one
+  */
+  void layout_graph(
+      mutable_graph_t *mg,
+      bool rebuilt)
+  {
+    // The neighbourhood view is transient
+    if (ego_mode || !options->persist_layout)
     {
-      // Get the group node id from the node group reference
-      pnodegroup_t ng = *it;
-      int ngid = get_ngid_from_ng(ng);
-      if (ngid == -1)
-        continue;
+      mg->redo_layout();
+      return;
+    }
 
-      gnode_t *gnode = get_node(ngid);
-      if (gnode == NULL)
-        continue;;
+    gvmembers_t members;
+    gvtexts_t texts;
+    get_node_members(mg, members, texts);
 
-      // Update the node display text
-      // TODO: PERFORMANCE: can you have gnode link to a groupman related structure and pull its
-      //                    text dynamically?
-      gnode->text = sg->get_display_name();
+    gvlayout_t prev;
+    if (rebuilt)
+    {
+      prev.load(func_fc->bounds.startEA, get_layout_tag());
+      if (prev.apply(mg, members, texts))
+      {
+        if (options->debug)
+          msg(STR_GS_MSG "Reused the saved layout\n");
+        return;
+      }
+    }
+    else
+    {
+      // Same graph, only the node sizes changed
+      prev.capture(mg, members, texts);
     }
 
-    if (!options->manual_refresh_mode)
-      refresh_view();
+    mg->redo_layout();
+    if (prev.seed(mg, members, texts, options->layout_seed_max_changed) && options->debug)
+      msg(STR_GS_MSG "Kept the previous positions of the unchanged nodes\n");
 
-    return true;
+    gvlayout_t layout;
+    layout.capture(mg, members, texts);
+    layout.save(func_fc->bounds.startEA, get_layout_tag());
   }
 
   /**
@@ -1609,7 +3069,8 @@ public:
       mg,
       node_map,
       func_fc,
-      options->append_node_id);
+      options->append_node_id,
+      &func_text);
     msg("done\n");
   }
 
@@ -1625,7 +3086,8 @@ public:
       node_map,
       ng2id,
       mg,
-      func_fc);
+      func_fc,
+      &func_text);
 
     msg("done\n");
   }
@@ -1698,25 +3160,121 @@ public:
   */
   void refresh_view()
   {
-    refresh_mode = gvrfm_single_mode;
-    //TODO: HACK: trigger a window to show/hide so IDA repaints the nodes
+    schedule_refresh(RFD_COLORS);
   }
 
   /**
-  * @brief Set refresh mode and issue a refresh
+  * @brief Set refresh mode and issue a refresh on the next idle tick
   */
   void redo_layout(gvrefresh_modes_e rm)
   {
-    refresh_mode = rm;
-    refresh_viewer(gv);
-    if (focus_node != -1)
+    schedule_refresh(RFD_TOPOLOGY, rm);
+  }
+
+  /**
+  * @brief Record a refresh request. Requests are coalesced until the next idle tick
+  * @param rm - the refresh mode of a relayout request. A hard mode overrides a soft one
+  */
+  void schedule_refresh(
+      int flags,
+      gvrefresh_modes_e rm = gvrfm_soft)
+  {
+    if ((flags & RFD_TOPOLOGY) != 0)
+    {
+      ++rsched.layout_requests;
+      if ((rsched.dirty & RFD_TOPOLOGY) == 0 || rm != gvrfm_soft)
+        rsched.layout_mode = rm;
+    }
+    else if ((flags & RFD_TEXT) != 0)
+    {
+      ++rsched.layout_requests;
+    }
+    else
+    {
+      ++rsched.repaint_requests;
+    }
+    rsched.dirty |= flags;
+
+    if (rsched.timer == NULL && gv != NULL)
+      rsched.timer = register_timer(REFRESH_TICK_MS, s_refresh_timer, this);
+
+    // No timer? Serve the request right away
+    if (rsched.timer == NULL)
+      flush_refresh();
+  }
+
+  /**
+  * @brief Serve the pending refresh requests now: at most one relayout or one repaint
+  */
+  void flush_refresh()
+  {
+    cancel_refresh();
+
+    int dirty = rsched.dirty;
+    rsched.dirty = 0;
+    if (dirty == 0 || gv == NULL)
+      return;
+
+    if ((dirty & (RFD_TOPOLOGY | RFD_TEXT)) != 0)
     {
-      focus_node = get_gvnid_from_nid(focus_node);
+      // A relayout repaints everything too
+      ++rsched.layouts;
+      refresh_mode = (dirty & RFD_TOPOLOGY) != 0 ? rsched.layout_mode : gvrfm_soft;
+      refresh_viewer(gv);
       if (focus_node != -1)
-        jump_to_node(gv, focus_node);
-      focus_node = -1;
+      {
+        int gr_nid = get_gvnid_from_nid(focus_node);
+        focus_node = -1;
+        if (gr_nid != -1)
+          jump_to_gvnode(gr_nid);
+      }
+    }
+    else
+    {
+      ++rsched.repaints;
+      refresh_mode = gvrfm_soft;
+      rsched.repaint_only = true;
+      refresh_viewer(gv);
+      rsched.repaint_only = false;
+    }
+  }
+
+  /**
+  * @brief Stop the idle tick timer. The dirty flags are kept
+  */
+  void cancel_refresh()
+  {
+    if (rsched.timer != NULL)
+    {
+      unregister_timer(rsched.timer);
+      rsched.timer = NULL;
     }
+  }
+
+  /**
+  * @brief Idle tick: serve the pending requests
+  */
+  static int idaapi s_refresh_timer(void *ud)
+  {
+    gsgraphview_t *_this = (gsgraphview_t *)ud;
+
+    // Returning -1 unregisters the timer
+    _this->rsched.timer = NULL;
+    _this->flush_refresh();
+    return -1;
+  }
 
+  /**
+  * @brief Display how many refreshes were coalesced
+  */
+  void dump_refresh_stats()
+  {
+    uint32 requests = rsched.repaint_requests + rsched.layout_requests;
+    uint32 done = rsched.repaints + rsched.layouts;
+    msg(STR_GS_MSG "Refreshes: %u/%u repaints, %u/%u layouts, %u saved\n",
+      rsched.repaints, rsched.repaint_requests,
+      rsched.layouts, rsched.layout_requests,
+      requests - done);
   }
 
   /**
@@ -1820,6 +3378,7 @@ public:
     idm_change_graph_layout           = add_menu("Change graph layout");
     idm_single_view_mode              = add_menu("Switch to ungroupped view",       "U");
     idm_combined_view_mode            = add_menu("Switch to groupped view",         "G");
+    idm_ego_mode                      = add_menu("Toggle neighbourhood view",       "N");
 
     // Experimental actions
 #ifndef PUBLIC
@@ -1842,6 +3401,14 @@ public:
     // Edit group description menu
     idm_edit_sg_desc                  = add_menu("Edit group description",          "E");
 
+    // Loop groupping actions
+    add_menu("-");
+    idm_collapse_loop                 = add_menu("Collapse loop",                   "L");
+    idm_expand_loop                   = add_menu("Expand loop",                     "X");
+    idm_group_loops                   = add_menu("Group by loops");
+    idm_group_sccs                    = add_menu("Group by strongly connected components");
+    idm_partition                     = add_menu("Partition into clusters");
+
     //
     // Dynamic menu items
     //
@@ -1875,6 +3442,12 @@ public:
       idm_highlight_similar(-1),
       idm_find_highlight(-1),
       idm_combine_ngs(-1),
+      idm_group_loops(-1),
+      idm_group_sccs(-1),
+      idm_partition(-1),
+      idm_ego_mode(-1),
+      idm_collapse_loop(-1),
+      idm_expand_loop(-1),
       idm_show_options(-1)
   {
     gv = NULL;
@@ -1885,8 +3458,19 @@ public:
     focus_node = -1;
     in_sel_mode = false;
     cur_node = -1;
+    it_selected_node = it_highlighted_node = -1;
+    memset(&rsched, 0, sizeof(rsched));
+    rsched.layout_mode = gvrfm_soft;
+    sg_index_dirty = true;
+    func_text_ea = BADADDR;
+    func_text_size = -1;
+    func_text_counter = 0;
+    node_index_ea = BADADDR;
+    node_index_size = -1;
+    node_index_counter = 0;
     idm_set_sel_mode = -1;
     idm_edit_sg_desc = -1;
+    ego_mode = false;
   }
 
 };
@@ -1916,6 +3500,12 @@ public:
   pnodegroup_t ng;
   pnodegroup_list_t ngl;
 
+  /**
+  * @brief The formatted description, valid once 'formatted' is set
+  */
+  qstring text;
+  bool formatted;
+
   /**
   * @brief Constructor
   */
@@ -1925,6 +3515,7 @@ public:
     sg = NULL;
     ng = NULL;
     ngl = NULL;
+    formatted = false;
   }
 };
 typedef qvector<gschooser_line_t> chooser_lines_vec_t;
@@ -1933,12 +3524,22 @@ typedef qvector<gschooser_line_t> chooser_lines_vec_t;
 /**
 * @brief GraphSlick chooser class
 */
-class gschooser_t: public gsgv_actions_t
+class gschooser_t: public gsgv_actions_t, public groupman_listener_t
 {
 private:
   static gschooser_t *singleton;
   chooser_lines_vec_t ch_nodes;
 
+  /**
+  * @brief Super groups whose lines are out of date
+  */
+  std::set<psupergroup_t> dirty_sgs;
+
+  /**
+  * @brief Set when all the lines are out of date
+  */
+  bool lines_reset;
+
   chooser_info_t chi;
   gsgraphview_t *gsgv;
   groupman_t *gm;
@@ -1948,6 +3549,7 @@ private:
   gsoptions_t options;
 
   PyBBMatcher *py_matcher;
+  NativeBBMatcher native_matcher;
 
   static uint32 idaapi s_sizer(void *obj)
   {
@@ -2053,9 +3655,7 @@ private:
 
       // Call Analyzer
       int_3dvec_t result;
-#ifndef NO_PYTHON
-      py_matcher->Analyze(f->startEA, result);
-#endif
+      analyze_function(f->startEA, result);
       if (!get_flowchart(f->startEA))
           return;
 
@@ -2063,7 +3663,10 @@ private:
       if (result.empty() || options.no_initial_path_info)
       {
           // Retrieve initial groupping information
-          build_groupman_from_fc(&func_fc, gm, true);
+          if (options.sese_initial_grouping)
+            build_groupman_from_sese(&func_fc, options.sese_max_region_size, gm, true);
+          else
+            build_groupman_from_fc(&func_fc, gm, true);
       }
       else
       {
@@ -2077,6 +3680,15 @@ private:
           build_groupman_from_3dvec(&func_fc, result, gm, true);
       }
 
+      // Still too many nodes to layout and nothing from the analyzer?
+      // Partition the function
+      if (    options.auto_partition
+           && (result.empty() || options.no_initial_path_info)
+           && get_groupman_ng_count(gm) > size_t(options.partition_node_budget))
+      {
+          build_groupman_from_partition(&func_fc, options.partition_node_budget, gm, true);
+      }
+
       if (gm->src_filename.empty() && def_filename != NULL)
           gm->src_filename = def_filename;
 
@@ -2176,6 +3788,12 @@ private:
                 it != groups->end();
                 ++it)
           {
+            // The chooser cannot show more anyway
+            if (out->length() >= CHOOSER_LINE_MAX)
+            {
+              out->append("...");
+              break;
+            }
             pnodedef_t nd = *it;
             out->cat_sprnt("%d:%a:%a", nd->nid, nd->start, nd->end);
             if (--sz > 0)
@@ -2236,11 +3854,15 @@ private:
 
       gschooser_line_t &cn = ch_nodes[n];
 
-      qstring desc;
-      get_node_desc(&cn, &desc, 1);
-      qstrncpy(arrptr[0], desc.c_str(), MAXSTR);
+      // Only the painted lines are formatted, once
+      if (!cn.formatted)
+      {
+        get_node_desc(&cn, &cn.text, 1);
+        cn.formatted = true;
+      }
+      qstrncpy(arrptr[0], cn.text.c_str(), MAXSTR);
 
-      desc.qclear();
+      qstring desc;
       get_node_desc(&cn, &desc, 2);
       qstrncpy(arrptr[1], desc.c_str(), MAXSTR);
     }
@@ -2306,7 +3928,7 @@ private:
       // Select the current node
       int nid = gsgv->get_ngid_from_ng(ng);
       if (nid != -1)
-        jump_to_node(gsgv->gv, nid);
+        gsgv->jump_to_gvnode(nid);
     }
   }
 
@@ -2326,8 +3948,6 @@ private:
     // Clear previous highlight
     gsgv->clear_highlighting(true);
 
-    DECL_CG;
-
     switch (chn.type)
     {
       //
@@ -2341,7 +3961,6 @@ private:
         // Mark them for selection
         gsgv->highlight_nodes(
             sgroups,
-            cg,
             true);
 
         break;
@@ -2352,18 +3971,22 @@ private:
       case chlt_ng:
       case chlt_sg:
       {
-        colorvargen_t cv;
-        bgcolor_t clr;
+        unsigned int color_key = get_sg_color_key(chn.sg);
 
         if (chn.type == chlt_ng)
         {
-          // Pick a color
-          cg.get_colorvar(cv);
-          clr = cg.get_color_anyway(cv);
+          // Use the same shade as when the whole super group is highlighted
+          unsigned int shade = 0;
+          for (nodegroup_list_t::iterator it=chn.ngl->begin();
+               it != chn.ngl->end() && *it != chn.ng;
+               ++it)
+          {
+            ++shade;
+          }
 
           gsgv->highlight_nodes(
               chn.ng,
-              clr,
+              colorpalette_t::instance().get_color(color_key, shade),
               true);
         }
         // super groups - chnt_sg
@@ -2372,7 +3995,7 @@ private:
           // Use one color for all the different node group list
           gsgv->highlight_nodes(
             chn.ngl,
-            cg,
+            color_key,
             true);
         }
         break;
@@ -2408,7 +4031,7 @@ private:
   void refresh(bool populate_lines)
   {
     if (populate_lines)
-      populate_chooser_lines();
+      update_chooser_lines();
 
     refresh_chooser(TITLE_GS_PANEL);
   }
@@ -2487,10 +4110,8 @@ private:
   */
   pnodegroup_list_t find_similar(intvec_t &sel_nodes)
   {
-#ifndef NO_PYTHON
-    //TODO:
     int_2dvec_t ng_vec;
-    if (!py_matcher->FindSimilar(sel_nodes, ng_vec) || ng_vec.empty())
+    if (!find_similar_nodes(sel_nodes, ng_vec) || ng_vec.empty())
       return NULL;
 
     // Build NG
@@ -2518,9 +4139,37 @@ private:
       }
     }
     return ngl;
-#else
-      return NULL;
-#endif
+  }
+
+  /**
+  * @brief Add the lines of a super group
+  */
+  void add_sg_lines(
+      chooser_lines_vec_t &lines,
+      psupergroup_t sg)
+  {
+    // Add the second-level node = a set of group defs
+    gschooser_line_t *line = &lines.push_back();
+    nodegroup_list_t &ngl = sg->groups;
+    line->type = chlt_sg;
+    line->gm   = gm;
+    line->sg   = sg;
+    line->ngl  = &ngl;
+
+    // Add each nodedef list within each node group
+    for (nodegroup_list_t::iterator it = ngl.begin();
+         it != ngl.end();
+         ++it)
+    {
+      pnodegroup_t ng = *it;
+      // Add the third-level node = nodedef
+      line = &lines.push_back();
+      line->type = chlt_ng;
+      line->gm   = gm;
+      line->sg   = sg;
+      line->ngl  = &ngl;
+      line->ng   = ng;
+    }
   }
 
   /**
@@ -2528,9 +4177,10 @@ private:
   */
   void populate_chooser_lines()
   {
-    // TODO: do not delete previous lines
 	// TODO: add option to show similar_sgs
     ch_nodes.clear();
+    dirty_sgs.clear();
+    lines_reset = false;
 
     // Add the first-level node = bbgroup file
     gschooser_line_t *line = &ch_nodes.push_back();
@@ -2542,31 +4192,155 @@ private:
          it != sgroups->end();
          ++it)
     {
-      supergroup_t &sg = **it;
+      add_sg_lines(ch_nodes, *it);
+    }
+  }
 
-      // Add the second-level node = a set of group defs
-      line = &ch_nodes.push_back();
-      nodegroup_list_t &ngl = sg.groups;
-      line->type = chlt_sg;
-      line->gm   = gm;
-      line->sg   = &sg;
-      line->ngl  = &ngl;
+  /**
+  * @brief Update the chooser lines after groupping changes. The lines of the
+  *        unchanged super groups are kept with their formatted text
+  */
+  void update_chooser_lines()
+  {
+    if (lines_reset || ch_nodes.empty())
+    {
+      populate_chooser_lines();
+      return;
+    }
+    if (dirty_sgs.empty())
+      return;
 
-      // Add each nodedef list within each node group
-      for (nodegroup_list_t::iterator it = ngl.begin();
-           it != ngl.end();
-           ++it)
+    // Locate the lines of the unchanged super groups
+    std::map<psupergroup_t, size_t> kept;
+    for (size_t i=1; i < ch_nodes.size(); i++)
+    {
+      gschooser_line_t &line = ch_nodes[i];
+      if (line.type == chlt_sg && dirty_sgs.find(line.sg) == dirty_sgs.end())
+        kept[line.sg] = i;
+    }
+
+    chooser_lines_vec_t lines;
+    lines.reserve(ch_nodes.size());
+
+    // The group file line
+    qswap(lines.push_back(), ch_nodes[0]);
+
+    psupergroup_listp_t sgroups = gm->get_path_sgl();
+    for (supergroup_listp_t::iterator it=sgroups->begin();
+         it != sgroups->end();
+         ++it)
+    {
+      psupergroup_t sg = *it;
+      std::map<psupergroup_t, size_t>::iterator it_kept = kept.find(sg);
+      if (it_kept == kept.end())
+      {
+        add_sg_lines(lines, sg);
+        continue;
+      }
+
+      // Move the super group line and its node group lines
+      size_t i = it_kept->second;
+      do
+      {
+        qswap(lines.push_back(), ch_nodes[i++]);
+      } while (i < ch_nodes.size() && ch_nodes[i].type == chlt_ng);
+    }
+    ch_nodes.swap(lines);
+    dirty_sgs.clear();
+  }
+
+  /**
+  * @brief Groupping change events
+  */
+  virtual void on_sg_changed(psupergroup_t sg)
+  {
+    dirty_sgs.insert(sg);
+  }
+
+  virtual void on_groups_reset()
+  {
+    lines_reset = true;
+    dirty_sgs.clear();
+  }
+
+  /**
+  * @brief Return the matcher selected in the options and the other one when
+  *        they should be compared
+  */
+  BBMatcher *get_matcher(BBMatcher **other = NULL)
+  {
+    BBMatcher *matcher = &native_matcher, *reference = NULL;
+#ifndef NO_PYTHON
+    if (py_matcher != NULL)
+    {
+      if (options.native_matcher)
+      {
+        reference = py_matcher;
+      }
+      else
       {
-        pnodegroup_t ng = *it;
-        // Add the third-level node = nodedef
-        line = &ch_nodes.push_back();
-        line->type = chlt_ng;
-        line->gm   = gm;
-        line->sg   = &sg;
-        line->ngl  = &ngl;
-        line->ng   = ng;
+        reference = matcher;
+        matcher = py_matcher;
       }
     }
+#endif
+    if (other != NULL)
+      *other = options.compare_matchers ? reference : NULL;
+
+    return matcher;
+  }
+
+  /**
+  * @brief Analyze a function with the selected matcher
+  */
+  void analyze_function(ea_t func_ea, int_3dvec_t &result)
+  {
+    BBMatcher *other;
+    BBMatcher *matcher = get_matcher(&other);
+    native_matcher.set_threads(options.matcher_threads);
+    matcher->SetLSHParams(options.lsh_bands, options.lsh_rows);
+    matcher->Analyze(func_ea, result);
+    if (other == NULL)
+      return;
+
+    int_3dvec_t other_result;
+    other->SetLSHParams(options.lsh_bands, options.lsh_rows);
+    other->Analyze(func_ea, other_result);
+    if (other_result == result)
+    {
+      msg(STR_GS_MSG "Matchers agree on %a: %d well formed function(s)\n",
+        func_ea,
+        int(result.size()));
+    }
+    else
+    {
+      msg(STR_GS_MSG "Matchers differ on %a: %d vs %d well formed function(s)\n",
+        func_ea,
+        int(result.size()),
+        int(other_result.size()));
+    }
+  }
+
+  /**
+  * @brief Find the node lists similar to the given one with the selected matcher
+  */
+  bool find_similar_nodes(intvec_t &node_list, int_2dvec_t &similar)
+  {
+    BBMatcher *other;
+    bool ok = get_matcher(&other)->FindSimilar(node_list, similar);
+    if (other == NULL)
+      return ok;
+
+    int_2dvec_t other_similar;
+    bool other_ok = other->FindSimilar(node_list, other_similar);
+    if (ok != other_ok || other_similar != similar)
+    {
+      msg(STR_GS_MSG "Matchers differ on the nodes similar to %d: %d vs %d node list(s)\n",
+        node_list.empty() ? -1 : node_list[0],
+        int(similar.size()),
+        int(other_similar.size()));
+    }
+    return ok;
   }
 
   /**
@@ -2574,12 +4348,21 @@ private:
   */
   bool get_flowchart(ea_t startEA)
   {
+    fccache_t *fcc = fccache_t::instance();
+    fcc->set_limits(
+      size_t(options.fc_cache_max_entries),
+      size_t(options.fc_cache_max_bytes));
+
     // Build the flowchart once
     if (!get_func_flowchart(startEA, func_fc))
     {
       msg(STR_GS_MSG "Could not build function flow chart at %a\n", startEA);
       return false;
     }
+
+    if (options.debug)
+      fcc->dump_stats(STR_GS_MSG);
+
     return true;
   }
 
@@ -2683,7 +4466,9 @@ public:
     gsgv = NULL;
     gm = NULL;
     py_matcher = NULL;
+    lines_reset = true;
     gm = new groupman_t();
+    gm->set_listener(this);
   }
 
   /**
@@ -2773,6 +4558,7 @@ public:
 
           // Assign new group manager
           gm = ngm;
+          gm->set_listener(this);
 
           populate_chooser_lines();
 
@@ -2808,7 +4594,9 @@ public:
       msg(STR_GS_MSG "Error: %s\n", err);
       delete py_matcher;
       py_matcher = NULL;
-      return false;
+
+      // The native matcher does not need Python
+      return options.native_matcher;
     }
 #endif
     return true;
@@ -2861,6 +4649,7 @@ int idaapi init(void)
 //--------------------------------------------------------------------------
 void idaapi term(void)
 {
+  fccache_t::instance()->unhook();
 }
 
 //--------------------------------------------------------------------------
@@ -4,6 +4,7 @@ History
 
 11/07/2013 - eliasb             - Initial version
 04/15/2014 - eliasb             - Check the result of PyAnalyze() before converting the result to C structs
+10/18/2026 - agent              - Added SetLSHParams()
 --------------------------------------------------------------------------*/
 
 #include "pybbmatcher.h"
@@ -148,6 +149,21 @@ bool PyBBMatcher::FindSimilar(intvec_t &node_list, int_2dvec_t &similar)
     return bOk;
 }
 
+//--------------------------------------------------------------------------
+void PyBBMatcher::SetLSHParams(int bands, int rows)
+{
+    if (py_instref == NULL)
+        return;
+
+    PYW_GIL_GET;
+    PyObject *py_bands = PyInt_FromLong(bands);
+    PyObject *py_rows = PyInt_FromLong(rows);
+    PyObject_SetAttrString(py_instref, "lshBands", py_bands);
+    PyObject_SetAttrString(py_instref, "lshRows", py_rows);
+    Py_DECREF(py_bands);
+    Py_DECREF(py_rows);
+}
+
 //--------------------------------------------------------------------------
 bool PyBBMatcher::SaveState(qstring &out)
 {
@@ -15,10 +15,10 @@ BBMatcher Python to C wrapper class
 #endif
 
 #include <Python.h>
-#include "types.hpp"
+#include "bbmatcher.hpp"
 
 //--------------------------------------------------------------------------
-class PyBBMatcher
+class PyBBMatcher: public BBMatcher
 {
   PyObject *py_matcher_module;
   PyObject *py_instref;
@@ -59,7 +59,7 @@ public:
   /**
   * @brief Analyze and return the non-overlapping wellformed function instances	
   */
-  void Analyze(ea_t func_addr, int_3dvec_t &result);
+  virtual void Analyze(ea_t func_addr, int_3dvec_t &result);
 
   /**
   * @brief Load state
@@ -74,7 +74,12 @@ public:
   /**
   * @brief Analyze and set the internal state
   */
-  bool FindSimilar(intvec_t &node_list, int_2dvec_t &similar);
+  virtual bool FindSimilar(intvec_t &node_list, int_2dvec_t &similar);
+
+  /**
+  * @brief Set the LSH parameters of the matcher instance
+  */
+  virtual void SetLSHParams(int bands, int rows);
 };
 
 #endif
\ No newline at end of file
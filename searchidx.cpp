@@ -0,0 +1,460 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Search index module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+                                - The regular expressions are verified with std::regex
+                                - The arguments of the escaped character codes are not required literals
+--------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <string.h>
+#include "searchidx.h"
+
+//--------------------------------------------------------------------------
+// Default count of cached query results
+static const size_t DEF_MAX_CACHED = 16;
+
+//--------------------------------------------------------------------------
+inline char to_lower(char c)
+{
+  return (c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+//--------------------------------------------------------------------------
+static void lower_str(const char *str, qstring *out)
+{
+  out->qclear();
+  for (; *str != '\0'; ++str)
+    out->append(to_lower(*str));
+}
+
+//--------------------------------------------------------------------------
+//
+//      REGULAR EXPRESSIONS
+//
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+/**
+* @brief Compile a case insensitive ECMAScript regular expression
+*/
+static bool re_compile(
+    const char *pattern,
+    std::regex &re)
+{
+  try
+  {
+    re.assign(pattern, std::regex::ECMAScript | std::regex::icase);
+  }
+  catch (const std::regex_error &)
+  {
+    return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Match a regular expression against each line of a text
+*/
+static bool re_search(
+    const std::regex &re,
+    const char *text)
+{
+  for (;;)
+  {
+    const char *eol = strchr(text, '\n');
+    const char *end = eol == NULL ? text + strlen(text) : eol;
+    if (std::regex_search(text, end, re))
+      return true;
+    if (eol == NULL)
+      return false;
+    text = eol + 1;
+  }
+}
+
+//--------------------------------------------------------------------------
+inline bool is_alpha(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+inline bool is_alnum(char c)
+{
+  return is_digit(c) || is_alpha(c);
+}
+
+inline bool is_xdigit(char c)
+{
+  return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Collect the lower case literal strings any match must contain.
+*        Only the literals outside of the groups are considered
+*/
+static void re_required_literals(
+    const char *pattern,
+    qstrvec_t &literals)
+{
+  // An alternative may avoid any literal
+  if (strchr(pattern, '|') != NULL)
+    return;
+
+  qstring run;
+  int depth = 0;
+  for (const char *p=pattern; *p != '\0'; )
+  {
+    char c = *p++;
+    bool literal = false;
+    if (c == '\\')
+    {
+      if (*p == '\0')
+        break;
+
+      // Escaped letters and digits are classes, anchors, back references
+      // or character codes. The arguments of the codes are not literals
+      c = *p++;
+      literal = !is_alnum(c);
+      if (c == 'x' || c == 'u')
+      {
+        for (int n=c == 'x' ? 2 : 4; n > 0 && is_xdigit(*p); n--)
+          ++p;
+      }
+      else if (c == 'c')
+      {
+        if (is_alpha(*p))
+          ++p;
+      }
+      else if (is_digit(c))
+      {
+        while (is_digit(*p))
+          ++p;
+      }
+    }
+    else if (c == '[')
+    {
+      // Skip the class
+      while (*p != '\0' && *p != ']')
+      {
+        if (*p++ == '\\' && *p != '\0')
+          ++p;
+      }
+      if (*p != '\0')
+        ++p;
+    }
+    else if (c == '{')
+    {
+      // Skip the counted repetition
+      while (*p != '\0' && *p++ != '}')
+        ;
+    }
+    else if (c == '(')
+    {
+      ++depth;
+    }
+    else if (c == ')')
+    {
+      --depth;
+    }
+    else
+    {
+      literal = strchr("^$.*+?}", c) == NULL;
+    }
+
+    // A quantifier may drop or repeat the item
+    bool optional = *p == '*' || *p == '?' || *p == '{';
+    if (literal && depth == 0 && !optional)
+      run.append(to_lower(c));
+
+    if (!literal || depth != 0 || optional || *p == '+')
+    {
+      if (!run.empty())
+        literals.push_back(run);
+      run.qclear();
+    }
+  }
+  if (!run.empty())
+    literals.push_back(run);
+}
+
+//--------------------------------------------------------------------------
+//
+//      THE INDEX
+//
+//--------------------------------------------------------------------------
+
+//--------------------------------------------------------------------------
+searchidx_t::searchidx_t()
+{
+  doc_count = 0;
+  max_cached = DEF_MAX_CACHED;
+  cache_hits = cache_misses = 0;
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::clear()
+{
+  docs.clear();
+  postings.clear();
+  cache.clear();
+  doc_count = 0;
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::set_cache_size(size_t n)
+{
+  max_cached = n;
+  while (cache.size() > max_cached)
+    cache.pop_back();
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::get_trigrams(
+    const char *str,
+    size_t len,
+    qvector<uint32> &trigrams)
+{
+  trigrams.qclear();
+  for (size_t i=0; i + 2 < len; i++)
+  {
+    trigrams.push_back(
+        (uint32(uchar(str[i])) << 16)
+      | (uint32(uchar(str[i + 1])) << 8)
+      |  uint32(uchar(str[i + 2])));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::add_postings(int id)
+{
+  const qstring &text = docs[id].text;
+
+  qvector<uint32> trigrams;
+  get_trigrams(text.c_str(), text.length(), trigrams);
+  for (size_t i=0; i < trigrams.size(); i++)
+  {
+    intvec_t &ids = postings[trigrams[i]];
+
+    // Documents are mostly added in increasing order
+    if (ids.empty() || ids.back() < id)
+      ids.push_back(id);
+    else
+      ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+  }
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::remove_postings(int id)
+{
+  const qstring &text = docs[id].text;
+
+  qvector<uint32> trigrams;
+  get_trigrams(text.c_str(), text.length(), trigrams);
+  for (size_t i=0; i < trigrams.size(); i++)
+  {
+    postings_t::iterator it = postings.find(trigrams[i]);
+    if (it == postings.end())
+      continue;
+
+    intvec_t &ids = it->second;
+    intvec_t::iterator p = std::lower_bound(ids.begin(), ids.end(), id);
+    if (p != ids.end() && *p == id)
+      ids.erase(p);
+    if (ids.empty())
+      postings.erase(it);
+  }
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::set_doc(int id, const char *text)
+{
+  if (id < 0)
+    return;
+
+  if (size_t(id) >= docs.size())
+    docs.resize(id + 1);
+
+  doc_t &doc = docs[id];
+  if (doc.used)
+    remove_postings(id);
+  else
+    ++doc_count;
+
+  doc.used = true;
+  lower_str(text, &doc.text);
+  add_postings(id);
+
+  cache.clear();
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::remove_doc(int id)
+{
+  if (id < 0 || size_t(id) >= docs.size() || !docs[id].used)
+    return;
+
+  remove_postings(id);
+  docs[id].used = false;
+  docs[id].text.qclear();
+  --doc_count;
+
+  cache.clear();
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::all_docs(intvec_t &ids)
+{
+  ids.qclear();
+  for (size_t i=0; i < docs.size(); i++)
+  {
+    if (docs[i].used)
+      ids.push_back(int(i));
+  }
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::intersect(
+    const qvector<uint32> &trigrams,
+    intvec_t &ids)
+{
+  ids.qclear();
+
+  // Start with the shortest list
+  qvector<const intvec_t *> lists;
+  for (size_t i=0; i < trigrams.size(); i++)
+  {
+    postings_t::const_iterator it = postings.find(trigrams[i]);
+    if (it == postings.end())
+      return;
+    lists.push_back(&it->second);
+  }
+  if (lists.empty())
+    return;
+
+  size_t shortest = 0;
+  for (size_t i=1; i < lists.size(); i++)
+  {
+    if (lists[i]->size() < lists[shortest]->size())
+      shortest = i;
+  }
+  ids = *lists[shortest];
+
+  for (size_t i=0; i < lists.size() && !ids.empty(); i++)
+  {
+    if (i == shortest)
+      continue;
+
+    // Both lists are sorted
+    const intvec_t &other = *lists[i];
+    size_t n = 0, j = 0;
+    for (size_t k=0; k < ids.size(); k++)
+    {
+      while (j < other.size() && other[j] < ids[k])
+        ++j;
+      if (j == other.size())
+        break;
+      if (other[j] == ids[k])
+        ids[n++] = ids[k];
+    }
+    ids.resize(n);
+  }
+}
+
+//--------------------------------------------------------------------------
+void searchidx_t::run_query(
+    const char *pattern,
+    const std::regex *re,
+    intvec_t &ids)
+{
+  ids.qclear();
+
+  qstring lpattern;
+  qstrvec_t literals;
+  if (re != NULL)
+  {
+    re_required_literals(pattern, literals);
+  }
+  else
+  {
+    lower_str(pattern, &lpattern);
+    literals.push_back(lpattern);
+  }
+
+  // Gather the trigrams of the required literals
+  qvector<uint32> trigrams, all;
+  for (size_t i=0; i < literals.size(); i++)
+  {
+    get_trigrams(literals[i].c_str(), literals[i].length(), trigrams);
+    all.insert(all.end(), trigrams.begin(), trigrams.end());
+  }
+
+  // Short queries have no trigrams: verify all the documents
+  intvec_t candidates;
+  if (all.empty())
+    all_docs(candidates);
+  else
+    intersect(all, candidates);
+
+  for (size_t i=0; i < candidates.size(); i++)
+  {
+    int id = candidates[i];
+    const char *text = docs[id].text.c_str();
+    bool ok = re != NULL ? re_search(*re, text) : strstr(text, lpattern.c_str()) != NULL;
+    if (ok)
+      ids.push_back(id);
+  }
+}
+
+//--------------------------------------------------------------------------
+bool searchidx_t::find(
+    const char *pattern,
+    bool regex,
+    intvec_t &ids)
+{
+  for (query_cache_t::iterator it=cache.begin(); it != cache.end(); ++it)
+  {
+    if (it->regex == regex && strcmp(it->pattern.c_str(), pattern) == 0)
+    {
+      ++cache_hits;
+      ids = it->ids;
+
+      // Move to the front
+      cache.splice(cache.begin(), cache, it);
+      return true;
+    }
+  }
+  ++cache_misses;
+
+  std::regex re;
+  if (regex && !re_compile(pattern, re))
+    return false;
+
+  run_query(pattern, regex ? &re : NULL, ids);
+
+  if (max_cached != 0)
+  {
+    cache.push_front(cached_query_t());
+    cached_query_t &q = cache.front();
+    q.pattern = pattern;
+    q.regex = regex;
+    q.ids = ids;
+    while (cache.size() > max_cached)
+      cache.pop_back();
+  }
+  return true;
+}
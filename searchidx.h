@@ -0,0 +1,141 @@
+#ifndef __SEARCHIDX__
+#define __SEARCHIDX__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Search index module
+
+This module implements a case insensitive trigram index over a set of
+text documents. Substring and regular expression queries only verify the
+documents holding all the trigrams the query requires.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <list>
+#include <map>
+#include <regex>
+#include <pro.h>
+
+//--------------------------------------------------------------------------
+/**
+* @brief Trigram index of text documents identified by an integer id
+*/
+class searchidx_t
+{
+private:
+  struct doc_t
+  {
+    /**
+    * @brief Lower case text of the document
+    */
+    qstring text;
+    bool used;
+
+    doc_t(): used(false)
+    {
+    }
+  };
+  typedef qvector<doc_t> doc_vec_t;
+
+  /**
+  * @brief Sorted document ids per trigram
+  */
+  typedef std::map<uint32, intvec_t> postings_t;
+
+  struct cached_query_t
+  {
+    qstring pattern;
+    bool regex;
+    intvec_t ids;
+  };
+  typedef std::list<cached_query_t> query_cache_t;
+
+  doc_vec_t docs;
+  postings_t postings;
+  int doc_count;
+
+  /**
+  * @brief Recent query results, the most recent first
+  */
+  query_cache_t cache;
+  size_t max_cached;
+
+  uint32 cache_hits, cache_misses;
+
+  /**
+  * @brief Collect the distinct trigrams of a lower case text
+  */
+  static void get_trigrams(
+    const char *str,
+    size_t len,
+    qvector<uint32> &trigrams);
+
+  void add_postings(int id);
+  void remove_postings(int id);
+
+  /**
+  * @brief Return the documents holding all the given trigrams
+  */
+  void intersect(
+    const qvector<uint32> &trigrams,
+    intvec_t &ids);
+
+  /**
+  * @brief Return all the documents
+  */
+  void all_docs(intvec_t &ids);
+
+  /**
+  * @brief Find the documents containing a substring or matching a
+  *        compiled regular expression (when 're' is not NULL)
+  */
+  void run_query(
+    const char *pattern,
+    const std::regex *re,
+    intvec_t &ids);
+
+public:
+  searchidx_t();
+
+  /**
+  * @brief Remove all the documents
+  */
+  void clear();
+
+  /**
+  * @brief Add a document or replace its text
+  */
+  void set_doc(int id, const char *text);
+
+  /**
+  * @brief Remove a document
+  */
+  void remove_doc(int id);
+
+  inline int size() const { return doc_count; }
+
+  /**
+  * @brief Find the documents containing a substring or matching a regular expression.
+  *        The regular expressions are case insensitive ECMAScript ones, matched
+  *        against each line of the documents
+  * @param ids - receives the sorted matching document ids
+  * @return False if the regular expression is invalid
+  */
+  bool find(
+    const char *pattern,
+    bool regex,
+    intvec_t &ids);
+
+  /**
+  * @brief Set the count of cached query results
+  */
+  void set_cache_size(size_t n);
+
+  inline uint32 get_cache_hits() const { return cache_hits; }
+  inline uint32 get_cache_misses() const { return cache_misses; }
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+SESE tree module
+
+The canonical region of a node 'a' is delimited by (a, ipdom(a)) when 'a'
+dominates its immediate post-dominator. The exit 'b' is then a child of 'a'
+in the dominator tree and the region is D(a) - D(b), D(x) being the nodes
+dominated by 'x'.
+
+The region is single-entry/single-exit when no edge leaves it for another
+node than 'b' and no edge enters it elsewhere than at 'a'. An edge can only
+enter a dominator subtree at its root, so both conditions are answered from
+per-subtree edge counts gathered in one pass over the edges. The lowest
+common dominator of the ends of an edge (u, v) is 'v' when 'v' dominates 'u'
+and idom(v) otherwise, which keeps the whole build linear.
+
+Verified regions are laminar: the tree is then assembled in one preorder
+walk of the dominator tree.
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "sesetree.h"
+
+//--------------------------------------------------------------------------
+void sesetree_t::clear()
+{
+  regions.qclear();
+  entry_region.qclear();
+  node_region.qclear();
+}
+
+//--------------------------------------------------------------------------
+bool sesetree_t::build(dominators_t &doms)
+{
+  clear();
+
+  const fcgraph_t &g = *doms.graph();
+  const domtree_t &dt = doms.get_domtree();
+
+  int node_count = g.size();
+  if (node_count == 0)
+    return false;
+
+  entry_region.resize(node_count, -1);
+  node_region.resize(node_count, -1);
+
+  //
+  // Count, for each dominator subtree D(x):
+  //   out       - the edges leaving D(x)
+  //   side/back - the edges leaving D(x) for D(idom(x)) - D(x), 'back' holds
+  //               the ones targeting idom(x) itself
+  //   unreached - the edges coming from unreachable nodes, summed over D(x)
+  //
+  int reached = dt.preorder_count();
+  intvec_t out(node_count, 0), side(node_count, 0), back(node_count, 0);
+  intvec_t unreached(node_count, 0), unreached_sum(node_count, 0);
+
+  // Ancestors of the current node in the dominator tree, indexed by depth
+  intvec_t depth(node_count, 0), path(reached, -1);
+  for (int i=0; i < reached; i++)
+  {
+    int u = dt.preorder_node(i);
+    int p = dt.idom(u);
+    depth[u] = p == -1 ? 0 : depth[p] + 1;
+    path[depth[u]] = u;
+
+    for (int j=0, npred=g.npred(u); j < npred; j++)
+    {
+      if (!dt.is_reachable(g.pred(u, j)))
+        ++unreached[u];
+    }
+    unreached_sum[u] = unreached[u];
+
+    for (int j=0, nsucc=g.nsucc(u); j < nsucc; j++)
+    {
+      int v = g.succ(u, j);
+      int lca = dt.dominates(v, u) ? v : dt.idom(v);
+      if (lca == u)
+        continue;
+
+      // The edge leaves every subtree on the path from 'u' up to below 'lca'
+      ++out[u];
+      --out[lca];
+
+      int top = path[depth[lca] + 1];
+      if (v == lca)
+        ++back[top];
+      else
+        ++side[top];
+    }
+  }
+
+  // Descendants have a higher preorder index: walking backward sums the subtrees
+  for (int i=reached - 1; i > 0; i--)
+  {
+    int n = dt.preorder_node(i);
+    int p = dt.idom(n);
+    out[p] += out[n];
+    unreached_sum[p] += unreached_sum[n];
+  }
+
+  // Reserve the root region's slot
+  regions.push_back();
+
+  //
+  // Verify the candidates, inner regions first
+  //
+  for (int i=reached - 1; i >= 0; i--)
+  {
+    int a = dt.preorder_node(i);
+    int b = doms.ipdom(a);
+    if (b == -1)
+      continue;
+
+    int leaving, entering, size;
+    if (b == doms.exit_node())
+    {
+      leaving  = out[a];
+      entering = unreached_sum[a] - unreached[a];
+      size     = dt.subtree_size(a);
+    }
+    else
+    {
+      if (dt.idom(b) != a)
+        continue;
+
+      // The edges leaving D(b) for D(a) - D(b) do not leave D(a)
+      leaving  = out[a] - (out[b] - side[b] - back[b]);
+
+      // Only 'b' may branch back into the region and only to its entry
+      entering = side[b] + unreached_sum[a] - unreached[a] - unreached_sum[b];
+      size     = dt.subtree_size(a) - dt.subtree_size(b);
+    }
+
+    // Single node regions are not worth remembering
+    if (leaving != 0 || entering != 0 || size < 2)
+      continue;
+
+    entry_region[a] = int(regions.size());
+    sese_region_t &r = regions.push_back();
+    r.entry = a;
+    r.exit  = b;
+    r.size  = size;
+  }
+
+  sese_region_t &root = regions[0];
+  root.entry = dt.root();
+  root.exit = doms.exit_node();
+  root.size = node_count;
+
+  //
+  // Assign the nodes and the regions to their innermost enclosing region.
+  // A node leaves the region of its immediate dominator only when it is its
+  // exit, then it belongs to the first enclosing region it is not the exit of
+  //
+  for (int i=0; i < reached; i++)
+  {
+    int n = dt.preorder_node(i);
+    int p = dt.idom(n);
+
+    int r = p == -1 ? 0 : node_region[p];
+    while (r != 0 && regions[r].exit == n)
+      r = regions[r].parent;
+
+    int c = entry_region[n];
+    if (c != -1)
+    {
+      regions[c].parent = r;
+      regions[r].children.push_back(c);
+      r = c;
+    }
+
+    node_region[n] = r;
+    regions[r].nodes.push_back(n);
+  }
+
+  // Unreachable nodes stay in the root region
+  for (int n=0; n < node_count; n++)
+  {
+    if (node_region[n] != -1)
+      continue;
+
+    node_region[n] = 0;
+    root.nodes.push_back(n);
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+void sesetree_t::get_region_nodes(int r, intvec_t &nodes) const
+{
+  intvec_t stk;
+  stk.push_back(r);
+  while (!stk.empty())
+  {
+    const sese_region_t &region = regions[stk.back()];
+    stk.pop_back();
+
+    nodes.insert(nodes.end(), region.nodes.begin(), region.nodes.end());
+
+    // Pushed backward so the nested regions come out in order
+    for (size_t i=region.children.size(); i > 0; i--)
+      stk.push_back(region.children[i - 1]);
+  }
+}
+
+//--------------------------------------------------------------------------
+void sesetree_t::build_grouping(
+    int max_region_size,
+    int_3dvec_t &groups,
+    intvec_t *sg_regions) const
+{
+  groups.qclear();
+  if (sg_regions != NULL)
+    sg_regions->qclear();
+
+  if (regions.empty())
+    return;
+
+  //
+  // List the regions that get opened: a region is opened when it is the
+  // root or too big to be collapsed. They are listed parents first with the
+  // nested regions in reverse, so walking the list backward emits the inner
+  // regions first and the siblings in order
+  //
+  intvec_t opened, stk;
+  stk.push_back(0);
+  while (!stk.empty())
+  {
+    int r = stk.back();
+    stk.pop_back();
+    opened.push_back(r);
+
+    const intvec_t &children = regions[r].children;
+    for (size_t i=0; i < children.size(); i++)
+    {
+      if (regions[children[i]].size > max_region_size)
+        stk.push_back(children[i]);
+    }
+  }
+
+  for (size_t k=opened.size(); k > 0; k--)
+  {
+    int r = opened[k - 1];
+    const sese_region_t &region = regions[r];
+
+    // Nodes that are directly held by the region stay on their own
+    int_2dvec_t sg;
+    for (size_t i=0; i < region.nodes.size(); i++)
+      sg.push_back().push_back(region.nodes[i]);
+
+    // Collapse each small enough nested region into one node group
+    for (size_t i=0; i < region.children.size(); i++)
+    {
+      int c = region.children[i];
+      if (regions[c].size <= max_region_size)
+        get_region_nodes(c, sg.push_back());
+    }
+
+    if (sg.empty())
+      continue;
+
+    groups.push_back(sg);
+    if (sg_regions != NULL)
+      sg_regions->push_back(r);
+  }
+}
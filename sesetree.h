@@ -0,0 +1,113 @@
+#ifndef __SESETREE__
+#define __SESETREE__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+SESE tree module
+
+This module builds the program structure tree of a flowchart: the nesting
+of its canonical single-entry/single-exit regions.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+#include "types.hpp"
+#include "domtree.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief A single-entry/single-exit region
+*/
+struct sese_region_t
+{
+  /**
+  * @brief Entry node and exit node. The exit node is not part of the region
+  */
+  int entry, exit;
+
+  /**
+  * @brief Parent region or -1 for the root region
+  */
+  int parent;
+
+  /**
+  * @brief Total count of nodes in the region, including the nested regions
+  */
+  int size;
+
+  /**
+  * @brief Nodes that belong to this region but not to a nested region
+  */
+  intvec_t nodes;
+
+  /**
+  * @brief Nested regions
+  */
+  intvec_t children;
+
+  sese_region_t(): entry(-1), exit(-1), parent(-1), size(0)
+  {
+  }
+};
+typedef qvector<sese_region_t> sese_region_vec_t;
+
+//--------------------------------------------------------------------------
+/**
+* @brief Program structure tree of canonical SESE regions
+*/
+class sesetree_t
+{
+private:
+  sese_region_vec_t regions;
+
+  /**
+  * @brief The region whose entry is a given node or -1
+  */
+  intvec_t entry_region;
+
+  /**
+  * @brief The innermost region holding each node
+  */
+  intvec_t node_region;
+
+public:
+  /**
+  * @brief Build the tree. Region 0 is always the root (the whole function)
+  */
+  bool build(dominators_t &doms);
+
+  /**
+  * @brief Clear the tree
+  */
+  void clear();
+
+  inline int size() const { return int(regions.size()); }
+  inline const sese_region_t &operator[](int r) const { return regions[r]; }
+
+  /**
+  * @brief Return the innermost region holding a node
+  */
+  inline int get_node_region(int n) const { return node_region[n]; }
+
+  /**
+  * @brief Return all the nodes of a region (nested ones included). The entry comes first
+  */
+  void get_region_nodes(int r, intvec_t &nodes) const;
+
+  /**
+  * @brief Build a grouping where every outermost region with at most
+  *        'max_region_size' nodes is collapsed into one node group.
+  *        Node groups coming from the same parent region share a super group
+  *        and the nodes directly held by that region get a node group each.
+  * @param sg_regions - optionally receives the parent region of each super group
+  */
+  void build_grouping(
+    int max_region_size,
+    int_3dvec_t &groups,
+    intvec_t *sg_regions = NULL) const;
+};
+
+#endif
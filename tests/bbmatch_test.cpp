@@ -0,0 +1,278 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Native BBMatch differential test
+
+Each case holds a synthetic flowchart, FindSimilar() queries and the
+results bb_match.py gave for them (see gen_bbmatch.py). The native matcher
+runs on the same flowchart through a synth_insn_decoder_t, with one and
+with several threads, and must give the same results.
+
+--------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nativebbmatcher.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief A test case read from a case file
+*/
+struct bbmatch_case_t
+{
+  qflow_chart_t fc;
+  synth_insn_decoder_t decoder;
+  int_2dvec_t queries;
+  qstrvec_t expected;
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Read the next integer of a line
+*/
+static bool read_int(const char **p, int *v)
+{
+  char *end;
+  long l = strtol(*p, &end, 10);
+  if (end == *p)
+    return false;
+
+  *v = int(l);
+  *p = end;
+  return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Read a count followed by as many integers
+*/
+static bool read_ints(const char **p, intvec_t &v)
+{
+  int count;
+  if (!read_int(p, &count))
+    return false;
+
+  for (int i=0; i < count; i++)
+  {
+    int x;
+    if (!read_int(p, &x))
+      return false;
+    v.push_back(x);
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Read a block line: start, end, the instructions (itype, size and
+*        operand pairs), the successors and the predecessors
+*/
+static bool read_block(const char *p, bbmatch_case_t &tc)
+{
+  int start, end, ninsns;
+  if (!read_int(&p, &start) || !read_int(&p, &end) || !read_int(&p, &ninsns))
+    return false;
+
+  qbasic_block_t &bb = tc.fc.blocks.push_back();
+  bb.startEA = start;
+  bb.endEA = end;
+
+  ea_t ea = start;
+  for (int i=0; i < ninsns; i++)
+  {
+    int itype, size, nops;
+    int ops[UA_MAXOP * 2];
+    if (    !read_int(&p, &itype)
+         || !read_int(&p, &size)
+         || !read_int(&p, &nops)
+         || nops > UA_MAXOP)
+    {
+      return false;
+    }
+
+    for (int k=0; k < nops * 2; k++)
+    {
+      if (!read_int(&p, &ops[k]))
+        return false;
+    }
+    ea = tc.decoder.add_insn(ea, uint16(itype), size, nops, ops);
+  }
+  return read_ints(&p, bb.succ) && read_ints(&p, bb.pred);
+}
+
+//--------------------------------------------------------------------------
+static bool read_case(const char *fn, bbmatch_case_t &tc)
+{
+  FILE *fp = fopen(fn, "r");
+  if (fp == NULL)
+    return false;
+
+  enum { SEC_NONE, SEC_BLOCKS, SEC_QUERIES, SEC_EXPECTED } section = SEC_NONE;
+
+  bool ok = true;
+  int count = 0;
+  static char line[64 * 1024];
+  while (ok && fgets(line, sizeof(line), fp) != NULL)
+  {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '#' || line[0] == '\0')
+      continue;
+
+    if (strncmp(line, "blocks ", 7) == 0)
+    {
+      section = SEC_BLOCKS;
+      count = atoi(line + 7);
+    }
+    else if (strncmp(line, "queries ", 8) == 0)
+    {
+      section = SEC_QUERIES;
+    }
+    else if (strcmp(line, "expected") == 0)
+    {
+      section = SEC_EXPECTED;
+    }
+    else if (section == SEC_BLOCKS)
+    {
+      ok = read_block(line, tc);
+    }
+    else if (section == SEC_QUERIES)
+    {
+      const char *p = line;
+      ok = read_ints(&p, tc.queries.push_back());
+    }
+    else if (section == SEC_EXPECTED)
+    {
+      tc.expected.push_back(line);
+    }
+    else
+    {
+      ok = false;
+    }
+  }
+  fclose(fp);
+
+  tc.fc.nproper = tc.fc.size();
+  return ok && tc.fc.size() == count;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Format a list of integers as Python's repr() without spaces
+*/
+static void append_list(qstring &out, const intvec_t &v)
+{
+  out.append('[');
+  for (size_t i=0; i < v.size(); i++)
+    out.cat_sprnt(i == 0 ? "%d" : ",%d", v[i]);
+  out.append(']');
+}
+
+static void append_list(qstring &out, const int_2dvec_t &v)
+{
+  out.append('[');
+  for (size_t i=0; i < v.size(); i++)
+  {
+    if (i != 0)
+      out.append(',');
+    append_list(out, v[i]);
+  }
+  out.append(']');
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Run the native matcher on a case and compare its results
+* @return true if they are the expected ones
+*/
+static bool run_case(const char *fn, bbmatch_case_t &tc, int threads)
+{
+  NativeBBMatcher m;
+  m.set_decoder(&tc.decoder);
+  m.set_threads(threads);
+
+  qstrvec_t results;
+
+  int_3dvec_t groups;
+  m.AnalyzeFlowchart(tc.fc, groups);
+
+  qstring &analysis = results.push_back();
+  analysis = "A [";
+  for (size_t i=0; i < groups.size(); i++)
+  {
+    if (i != 0)
+      analysis.append(',');
+    append_list(analysis, groups[i]);
+  }
+  analysis.append(']');
+
+  for (size_t i=0; i < tc.queries.size(); i++)
+  {
+    int_2dvec_t similar;
+    bool ok = m.FindSimilar(tc.queries[i], similar);
+
+    qstring &line = results.push_back();
+    line.sprnt("F %d ", ok ? 1 : 0);
+    append_list(line, similar);
+  }
+
+  if (results.size() != tc.expected.size())
+  {
+    printf("%s (%d threads): %d results, %d expected\n",
+      fn, threads, int(results.size()), int(tc.expected.size()));
+    return false;
+  }
+
+  for (size_t i=0; i < results.size(); i++)
+  {
+    if (results[i] == tc.expected[i])
+      continue;
+
+    printf("%s (%d threads): result %d differs\n  got:      %s\n  expected: %s\n",
+      fn, threads, int(i), results[i].c_str(), tc.expected[i].c_str());
+    return false;
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    printf("usage: bbmatch_test case_files...\n");
+    return 2;
+  }
+
+  static const int thread_counts[] = { 1, 4 };
+
+  int failures = 0;
+  for (int i=1; i < argc; i++)
+  {
+    bbmatch_case_t tc;
+    if (!read_case(argv[i], tc))
+    {
+      printf("%s: bad case file\n", argv[i]);
+      ++failures;
+      continue;
+    }
+
+    for (size_t k=0; k < qnumber(thread_counts); k++)
+    {
+      if (!run_case(argv[i], tc, thread_counts[k]))
+      {
+        ++failures;
+        break;
+      }
+    }
+  }
+
+  if (failures != 0)
+  {
+    printf("bbmatch_test: %d of %d case(s) failed\n", failures, argc - 1);
+    return 1;
+  }
+  printf("bbmatch_test: %d case(s) ok\n", argc - 1);
+  return 0;
+}
@@ -0,0 +1,206 @@
+"""
+Generates the bbmatch_test fixtures from bb_match.py
+
+Each case is a random flowchart made of a few copies of a template
+subgraph, its synthetic instructions, a list of FindSimilar() queries and
+the results of bb_match.py for them. bbmatch_test runs the native matcher
+on the same flowchart and expects the same results.
+
+Runs with the Python 2 interpreter of IDA, outside of IDA:
+
+    python gen_bbmatch.py [case count] [first seed]
+"""
+
+import os
+import sys
+import glob
+import random
+import shutil
+import tarfile
+import tempfile
+
+TESTS_DIR  = os.path.dirname(os.path.abspath(__file__))
+BBGROUP_DIR = os.path.join(TESTS_DIR, '..', 'bbgroup')
+CASES_DIR  = os.path.join(TESTS_DIR, 'bbmatch')
+
+# The stand-ins for idaapi/idautils come first
+sys.path.insert(0, TESTS_DIR)
+sys.path.insert(1, BBGROUP_DIR)
+
+import idaapi
+
+MAX_QUERIES = 40
+
+# ------------------------------------------------------------------------------
+def gen_flowchart(r):
+    """Return the instructions, successors and predecessors of each block"""
+    def rand_insn():
+        return (r.randint(1, 6), r.randint(1, 4), [(k, r.randint(1, 3)) for k in xrange(r.randint(0, 2))])
+
+    def rand_block():
+        return [rand_insn() for _ in xrange(r.randint(1, 12))]
+
+    def variant(b):
+        b = list(b)
+        x = r.random()
+        if x < 0.5:
+            return b
+        if x < 0.7:
+            r.shuffle(b)
+            return b
+        if x < 0.9:
+            b[r.randrange(len(b))] = rand_insn()
+            return b
+        return rand_block()
+
+    # Copies of a template subgraph, slightly altered
+    ntpl = r.randint(3, 20)
+    tpl = [rand_block() for _ in xrange(ntpl)]
+    tedges = [(i, j) for i in xrange(ntpl) for j in xrange(ntpl)
+              if i != j and r.random() < (0.85 if j == i + 1 else 0.1)]
+
+    blocks = []
+    edges = []
+    for c in xrange(r.randint(1, 6)):
+        base = len(blocks)
+        for b in tpl:
+            blocks.append(variant(b))
+        for (i, j) in tedges:
+            if r.random() < 0.97:
+                edges.append((base + i, base + j))
+
+    # Some noise
+    for _ in xrange(r.randint(0, 10)):
+        blocks.append(rand_block() if r.random() < 0.6 else variant(r.choice(tpl)))
+
+    n = len(blocks)
+    perm = range(n)
+    if r.random() < 0.5:
+        r.shuffle(perm)
+
+    shuffled = [None] * n
+    for i in xrange(n):
+        shuffled[perm[i]] = blocks[i]
+    edges = [(perm[a], perm[b]) for (a, b) in edges]
+    for _ in xrange(r.randint(0, n // 3)):
+        edges.append((r.randrange(n), r.randrange(n)))
+
+    succ = [[] for _ in xrange(n)]
+    for (a, b) in edges:
+        if b not in succ[a]:
+            succ[a].append(b)
+
+    pred = [[] for _ in xrange(n)]
+    for a in xrange(n):
+        for b in succ[a]:
+            pred[b].append(a)
+
+    return shuffled, succ, pred
+
+# ------------------------------------------------------------------------------
+def gen_queries(r, m, count):
+    """Single nodes, parts of the matched paths and random node pairs"""
+    qs = [[r.randrange(count)] for _ in xrange(3)]
+    for h in m.pathPerNodeHashFull.values():
+        for paths in h.values():
+            p = r.choice(paths)
+            for k in (2, 3, len(p)):
+                if k > len(p):
+                    continue
+                if r.random() < 0.7:
+                    qs.append(sorted(r.sample(p, k), key=p.index))
+                else:
+                    qs.append(r.sample(p, k))
+    if count > 1:
+        qs += [r.sample(xrange(count), 2) for _ in xrange(3)]
+    return qs[:MAX_QUERIES]
+
+# ------------------------------------------------------------------------------
+def fmt(obj):
+    return repr(obj).replace(' ', '')
+
+# ------------------------------------------------------------------------------
+def gen_case(bb_match, seed):
+    r = random.Random(seed)
+    blocks, succ, pred = gen_flowchart(r)
+
+    idaapi.INSNS.clear()
+    del idaapi.BLOCKS[:]
+
+    lines = ['# Generated by gen_bbmatch.py from seed %d' % seed]
+    lines.append('blocks %d' % len(blocks))
+    for i, b in enumerate(blocks):
+        start = ea = 0x1000 + i * 0x100
+        insns = []
+        for (itype, size, ops) in b:
+            idaapi.INSNS[ea] = (itype, ops, size)
+            insns.append(' '.join(['%d %d %d' % (itype, size, len(ops))] + ['%d %d' % op for op in ops]))
+            ea += size
+        idaapi.BLOCKS.append((start, ea, succ[i], pred[i]))
+        lines.append(' '.join(
+            ['%d %d %d' % (start, ea, len(b))] + insns +
+            [str(len(succ[i]))] + map(str, succ[i]) +
+            [str(len(pred[i]))] + map(str, pred[i])))
+
+    # Start from a clean analysis cache
+    for f in glob.glob('*.cache'):
+        if not f.startswith('Primes'):
+            os.remove(f)
+
+    m = bb_match.bbMatcher
+    result = m.Analyze(0x1000)
+    expected = ['A ' + fmt(result)]
+
+    qs = gen_queries(r, m, len(blocks))
+    lines.append('queries %d' % len(qs))
+    for q in qs:
+        lines.append(' '.join([str(len(q))] + map(str, q)))
+        try:
+            similar = m.FindSimilar(list(q))
+            ok = 1
+        except Exception:
+            similar = []
+            ok = 0
+        expected.append('F %d %s' % (ok, fmt(similar)))
+
+    lines.append('expected')
+    lines += expected
+    return '\n'.join(lines) + '\n', len(result) > 0
+
+# ------------------------------------------------------------------------------
+def main():
+    count = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+    seed = int(sys.argv[2]) if len(sys.argv) > 2 else 0
+
+    if not os.path.exists(CASES_DIR):
+        os.makedirs(CASES_DIR)
+
+    # bb_match.py writes its caches in the current directory
+    work = tempfile.mkdtemp()
+    os.chdir(work)
+    try:
+        try:
+            import ordered_set
+        except ImportError:
+            tar = tarfile.open(os.path.join(BBGROUP_DIR, '3rdparty', 'ordered-set-1.1.tar.gz'))
+            f = tar.extractfile('ordered-set-1.1/ordered_set.py')
+            open('ordered_set.py', 'w').write(f.read())
+            sys.path.insert(0, work)
+
+        import bb_match
+
+        # As many cases with matches as without
+        written = [0, 0]
+        while sum(written) < count:
+            text, matched = gen_case(bb_match, seed)
+            if written[matched] < (count + 1 - matched) // 2:
+                name = 'case%04d.txt' % seed
+                open(os.path.join(CASES_DIR, name), 'w').write(text)
+                written[matched] += 1
+                print '%s: %s' % (name, 'matched' if matched else 'no match')
+            seed += 1
+    finally:
+        os.chdir(TESTS_DIR)
+        shutil.rmtree(work)
+
+main()
@@ -0,0 +1,68 @@
+"""
+Minimal idaapi stand-in used by gen_bbmatch.py to run bb_match.py outside
+of IDA. The flowchart and the instructions are the ones of the case being
+generated: BLOCKS and INSNS are filled by the generator.
+"""
+
+UA_MAXOP = 6
+o_last   = 14
+o_void   = 0
+
+# ea -> (itype, [(operand number, operand type), ...], size)
+INSNS = {}
+
+# (startEA, endEA, succs, preds)
+BLOCKS = []
+
+# ------------------------------------------------------------------------------
+class op_t(object):
+    def __init__(self, n, type):
+        self.n = n
+        self.type = type
+
+class insn_t(object):
+    pass
+
+def DecodeInstruction(ea):
+    if ea not in INSNS:
+        return None
+    itype, ops, size = INSNS[ea]
+    cmd = insn_t()
+    cmd.itype = itype
+    cmd.size = size
+    cmd.Operands = [op_t(n, t) for (n, t) in ops]
+    cmd.Operands += [op_t(len(ops) + k, o_void) for k in xrange(UA_MAXOP - len(ops))]
+    return cmd
+
+# ------------------------------------------------------------------------------
+class func_t(object):
+    startEA = 0x1000
+
+def get_func(ea):
+    return func_t()
+
+def get_many_bytes(ea, size):
+    # Same as the synthetic decoder: unset bytes are zero
+    return '\0' * size
+
+# ------------------------------------------------------------------------------
+class BasicBlock(object):
+    def __init__(self, id):
+        self.id = id
+        self.startEA, self.endEA = BLOCKS[id][0], BLOCKS[id][1]
+
+    def succs(self):
+        for n in BLOCKS[self.id][2]:
+            yield BasicBlock(n)
+
+    def preds(self):
+        for n in BLOCKS[self.id][3]:
+            yield BasicBlock(n)
+
+class FlowChart(object):
+    def __init__(self, f = None, bounds = None, flags = 0):
+        pass
+
+    def __iter__(self):
+        for n in xrange(len(BLOCKS)):
+            yield BasicBlock(n)
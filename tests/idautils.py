@@ -0,0 +1,5 @@
+"""
+Minimal idautils stand-in used by gen_bbmatch.py (see idaapi.py)
+"""
+
+from idaapi import DecodeInstruction
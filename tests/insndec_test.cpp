@@ -0,0 +1,132 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Instruction decoder test
+
+Decodes a synthetic instruction stream and checks that the block features
+computed from it only depend on the decoded instructions.
+
+--------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include "insndec.h"
+#include "bbfeatures.h"
+
+//--------------------------------------------------------------------------
+static int failures = 0;
+
+#define CHECK(cond)                                               \
+  do                                                              \
+  {                                                               \
+    if (!(cond))                                                  \
+    {                                                             \
+      printf("%s(%d): check failed: %s\n", __FILE__, __LINE__, #cond); \
+      ++failures;                                                 \
+    }                                                             \
+  } while (0)
+
+//--------------------------------------------------------------------------
+static void test_decode()
+{
+  synth_insn_decoder_t dec;
+
+  static const int ops[] = { 0, o_reg, 1, o_imm };
+  ea_t next = dec.add_insn(0x1000, 7, 3, 2, ops);
+  CHECK(next == 0x1003);
+
+  insn_desc_t insn;
+  CHECK(dec.decode(0x1000, &insn));
+  CHECK(insn.itype == 7 && insn.size == 3 && insn.nops == 2);
+  CHECK(insn.ops[0] == get_op_code(0, o_reg));
+  CHECK(insn.ops[1] == get_op_code(1, o_imm));
+
+  // Nothing in the middle of an instruction or past the stream
+  CHECK(!dec.decode(0x1001, &insn));
+  CHECK(!dec.decode(next, &insn));
+
+  // A void operand ends the operand list as with the IDA decoder
+  static const int void_ops[] = { 0, o_void, 1, o_reg };
+  dec.add_insn(next, 8, 1, 2, void_ops);
+  CHECK(dec.decode(next, &insn) && insn.nops == 0);
+
+  // Unset bytes read as zero
+  static const uchar code[] = { 0x55, 0x8B, 0xEC };
+  dec.set_bytes(0x1000, code, sizeof(code));
+  uchar buf[4];
+  dec.get_bytes(0x1000, buf, sizeof(buf));
+  CHECK(buf[0] == 0x55 && buf[1] == 0x8B && buf[2] == 0xEC && buf[3] == 0);
+
+  dec.clear();
+  CHECK(!dec.decode(0x1000, &insn));
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Add a block made of (itype, operand type) instructions
+*/
+static void add_block(
+    synth_insn_decoder_t &dec,
+    qflow_chart_t &fc,
+    ea_t start,
+    const int *insns,
+    int count)
+{
+  qbasic_block_t &bb = fc.blocks.push_back();
+  bb.startEA = start;
+  for (int i=0; i < count; i++)
+  {
+    int ops[] = { 0, insns[i*2 + 1] };
+    start = dec.add_insn(start, uint16(insns[i*2]), 2, 1, ops);
+  }
+  bb.endEA = start;
+}
+
+//--------------------------------------------------------------------------
+static void test_features()
+{
+  static const int base[]      = { 1, o_reg, 2, o_imm, 3, o_mem };
+  static const int reordered[] = { 3, o_mem, 1, o_reg, 2, o_imm };
+  static const int retyped[]   = { 1, o_reg, 2, o_reg, 3, o_mem };
+
+  synth_insn_decoder_t dec;
+  qflow_chart_t fc;
+  add_block(dec, fc, 0x1000, base, 3);
+  add_block(dec, fc, 0x2000, base, 3);
+  add_block(dec, fc, 0x3000, reordered, 3);
+  add_block(dec, fc, 0x4000, retyped, 3);
+
+  bbfeatures_t features;
+  features.build(fc, 32, &dec);
+  CHECK(features.size() == 4);
+
+  for (int n=0; n < features.size(); n++)
+    CHECK(features.get_icount(n) == 3);
+
+  // Same instructions at another address
+  CHECK(features.get_hash1(0) == features.get_hash1(1));
+  CHECK(features.get_hash2(0) == features.get_hash2(1));
+
+  // The itype2 hash ignores the instructions order
+  CHECK(features.get_hash1(0) != features.get_hash1(2));
+  CHECK(features.get_hash2(0) == features.get_hash2(2));
+
+  // The itype1 hash ignores the operands
+  CHECK(features.get_hash1(0) == features.get_hash1(3));
+  CHECK(features.get_hash2(0) != features.get_hash2(3));
+}
+
+//--------------------------------------------------------------------------
+int main()
+{
+  test_decode();
+  test_features();
+
+  if (failures != 0)
+  {
+    printf("insndec_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("insndec_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,54 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Test kernel module
+
+The tests run outside of IDA. They are linked with the SDK's pro and dumb
+libraries like stdalone.vcxproj; this module replaces the few kernel and
+plugin functions the tested modules still reference. The instructions
+always come from a synth_insn_decoder_t.
+
+--------------------------------------------------------------------------*/
+
+#include <string.h>
+#include <pro.h>
+#include <ua.hpp>
+#include <bytes.hpp>
+#include "util.h"
+
+//--------------------------------------------------------------------------
+insn_t cmd;
+
+//--------------------------------------------------------------------------
+int ida_export decode_insn(ea_t)
+{
+  return 0;
+}
+
+//--------------------------------------------------------------------------
+bool ida_export get_many_bytes(ea_t, void *buf, ssize_t size)
+{
+  memset(buf, 0, size);
+  return false;
+}
+
+//--------------------------------------------------------------------------
+bool get_func_flowchart(
+    ea_t,
+    qflow_chart_t &)
+{
+  return false;
+}
+
+//--------------------------------------------------------------------------
+const qflow_chart_t *get_func_flowchart(ea_t)
+{
+  return NULL;
+}
+
+//--------------------------------------------------------------------------
+int get_cpu_count()
+{
+  return 2;
+}
@@ -0,0 +1,121 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Search index test
+
+The trigram prefilter may only drop documents that cannot match: the
+results of each query must be the ones of a full scan of the documents.
+
+--------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+#include "searchidx.h"
+
+//--------------------------------------------------------------------------
+static const char *const docs[] =
+{
+  "push ebp\nmov ebp, esp\ncall Alpha_Func",
+  "call Beta_Func\nretn",
+  "mov eax, 41h\nxor eax, eax",
+  "lea ecx, [ebp+var_4]\ncall ds:GetProcAddress",
+  "jmp short loc_401000\nALPHA:\nnop",
+  "cmp al, 0Ah\njz short loc_2",
+};
+
+static const char *const patterns[] =
+{
+  "alpha",
+  "\\x41lpha",
+  "\\u0041lpha_func",
+  "call \\x41",
+  "\\x4",
+  "\\cJ",
+  "\\0",
+  "mov e(a)x, \\x34\\x31h",
+  "(ebp)[+]var_\\d",
+  "loc_\\d+",
+  "beta_fun?c",
+  "x{2}or",
+  "get(proc)?address",
+  "retn|nop",
+  "^call",
+  "ebp$",
+  "[a-c]l ",
+  "(",
+};
+
+//--------------------------------------------------------------------------
+/**
+* @brief Scan every line of every document
+*/
+static bool scan(const char *pattern, intvec_t &ids)
+{
+  std::regex re;
+  try
+  {
+    re.assign(pattern, std::regex::ECMAScript | std::regex::icase);
+  }
+  catch (const std::regex_error &)
+  {
+    return false;
+  }
+
+  for (size_t i=0; i < qnumber(docs); i++)
+  {
+    const char *text = docs[i];
+    for (;;)
+    {
+      const char *eol = strchr(text, '\n');
+      const char *end = eol == NULL ? text + strlen(text) : eol;
+      if (std::regex_search(text, end, re))
+      {
+        ids.push_back(int(i));
+        break;
+      }
+      if (eol == NULL)
+        break;
+      text = eol + 1;
+    }
+  }
+  return true;
+}
+
+//--------------------------------------------------------------------------
+int main()
+{
+  searchidx_t idx;
+  for (size_t i=0; i < qnumber(docs); i++)
+    idx.set_doc(int(i), docs[i]);
+
+  int failures = 0;
+  for (size_t i=0; i < qnumber(patterns); i++)
+  {
+    intvec_t found, expected;
+    bool ok = idx.find(patterns[i], true, found);
+    bool expected_ok = scan(patterns[i], expected);
+    if (ok == expected_ok && found == expected)
+      continue;
+
+    printf("searchidx_test: '%s' found %d document(s), expected %d\n",
+      patterns[i], int(found.size()), int(expected.size()));
+    ++failures;
+  }
+
+  // The reported case
+  intvec_t ids;
+  if (!idx.find("\\x41lpha", true, ids) || ids.empty() || ids[0] != 0)
+  {
+    printf("searchidx_test: '\\x41lpha' does not find 'call Alpha_Func'\n");
+    ++failures;
+  }
+
+  if (failures != 0)
+  {
+    printf("searchidx_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("searchidx_test: ok\n");
+  return 0;
+}
@@ -22,6 +22,33 @@ struct gnode_t
   int id;
   qstring text;
   qstring hint;
+
+  /**
+  * @brief Text owned by someone else (pooled disassembly). Used when 'text' is empty
+  */
+  const char *text_ref;
+
+  gnode_t(): id(0), text_ref(NULL)
+  {
+  }
+
+  /**
+  * @brief Return the node display text
+  */
+  inline const char *get_text() const
+  {
+    return text_ref != NULL && text.empty() ? text_ref : text.c_str();
+  }
+
+  /**
+  * @brief Return the node hint: the 'hint' field then the referenced text then 'text'
+  */
+  inline const char *get_hint() const
+  {
+    if (!hint.empty())
+      return hint.c_str();
+    return text_ref != NULL ? text_ref : text.c_str();
+  }
 };
 
 //--------------------------------------------------------------------------
@@ -1,6 +1,10 @@
 #include "util.h"
+#include "fccache.h"
 #include <kernwin.hpp>
 #include <prodir.h>
+#ifndef __NT__
+#include <unistd.h>
+#endif
 
 /*--------------------------------------------------------------------------
 
@@ -12,6 +16,9 @@ History
 10/25/2013 - eliasb   - Added jump_to_node()
 10/30/2013 - eliasb   - moved str2asizet() and skip_spaces() from other modules
 10/31/2013 - eliasb   - added 'is_ida_gui()'
+10/18/2026 - agent    - added 'get_cpu_count()'
+                      - added a get_func_flowchart() that does not copy the cached flowchart
+                      - removed 'get_disasm_text()', the node texts come from fctext_t
 --------------------------------------------------------------------------*/
 
 //--------------------------------------------------------------------------
@@ -54,51 +61,19 @@ const char *get_screen_function_fn(const char *ext)
 
 //--------------------------------------------------------------------------
 /**
-* @brief Get the disassembly text into a qstring
+* @brief Return a function flowchart. It comes from the flowchart cache when possible
 */
-void get_disasm_text(
-    ea_t start, 
-    ea_t end, 
-    qstring *out)
+bool get_func_flowchart(
+  ea_t ea, 
+  qflow_chart_t &qf)
 {
-  // Generate disassembly text
-  text_t txt;
-  gen_disasm_text(
-    start, 
-    end, 
-    txt, 
-    false);
-
-  // Append all disasm lines
-  for (text_t::iterator it=txt.begin(); it != txt.end(); ++it)
-  {
-    out->append(it->line);
-    out->append("\n");
-  }
+  return fccache_t::instance()->get_flowchart(ea, qf);
 }
 
 //--------------------------------------------------------------------------
-/**
-* @brief Build a function flowchart
-*/
-bool get_func_flowchart(
-  ea_t ea, 
-  qflow_chart_t &qf)
+const qflow_chart_t *get_func_flowchart(ea_t ea)
 {
-  func_t *f = get_func(ea);
-  if (f == NULL)
-    return false;
-
-  qstring s;
-  s.sprnt("$ flowchart of %a()", f->startEA);
-  qf.create(
-    s.c_str(), 
-    f, 
-    BADADDR, 
-    BADADDR, 
-    FC_PREDS);
-
-  return true;
+  return fccache_t::instance()->get_flowchart(ea);
 }
 
 //--------------------------------------------------------------------------
@@ -124,3 +99,15 @@ bool is_ida_gui()
 {
   return callui(ui_get_hwnd).vptr != NULL || is_idaq();
 }
+
+//--------------------------------------------------------------------------
+int get_cpu_count()
+{
+#ifdef __NT__
+  const char *s = getenv("NUMBER_OF_PROCESSORS");
+  int n = s == NULL ? 1 : atoi(s);
+#else
+  int n = int(sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+  return n < 1 ? 1 : n;
+}
@@ -20,18 +20,37 @@ This module implements various utility functions
 
 //--------------------------------------------------------------------------
 /**
-* @brief Utility map class to store gnode_t types
+* @brief Utility class to store gnode_t types. The graph node ids are dense
+*        so the nodes are stored in an array indexed by the node id
 */
-class gnodemap_t: public std::map<int, gnode_t>
+class gnodemap_t
 {
+private:
+  qvector<gnode_t> nodes;
+  boolvec_t present;
+  size_t count;
+
 public:
+  gnodemap_t(): count(0)
+  {
+  }
+
   /**
-  * @brief Add a node to the map
+  * @brief Add a node to the map. An existing node is returned as is
   */
   gnode_t *add(int nid)
   {
-    gnode_t *node = &(insert(std::make_pair(nid, gnode_t())).first->second);
-    return node;
+    if (size_t(nid) >= nodes.size())
+    {
+      nodes.resize(nid + 1);
+      present.resize(nid + 1, false);
+    }
+    if (!present[nid])
+    {
+      present[nid] = true;
+      ++count;
+    }
+    return &nodes[nid];
   }
 
   /**
@@ -39,24 +58,54 @@ public:
   */
   gnode_t *get(int nid)
   {
-    gnodemap_t::iterator it = find(nid);
-    if ( it == end() )
+    if (nid < 0 || size_t(nid) >= nodes.size() || !present[nid])
       return NULL;
     else
-      return &it->second;
+      return &nodes[nid];
+  }
+
+  /**
+  * @brief Return the count of nodes
+  */
+  inline size_t size() const { return count; }
+  inline bool empty() const { return count == 0; }
+
+  void clear()
+  {
+    nodes.clear();
+    present.clear();
+    count = 0;
+  }
+
+  void swap(gnodemap_t &other)
+  {
+    nodes.swap(other.nodes);
+    present.swap(other.present);
+    qswap(count, other.count);
+  }
+
+  /**
+  * @brief Return the memory used in bytes. Referenced texts are not counted
+  */
+  size_t memory_usage() const
+  {
+    size_t mem = sizeof(*this) + nodes.size() * (sizeof(gnode_t) + sizeof(bool));
+    for (size_t i=0; i < nodes.size(); i++)
+      mem += nodes[i].text.length() + nodes[i].hint.length();
+    return mem;
   }
 };
 
 //--------------------------------------------------------------------------
-void get_disasm_text(
-    ea_t start, 
-    ea_t end, 
-    qstring *out);
-
 bool get_func_flowchart(
     ea_t ea, 
     qflow_chart_t &qf);
 
+/**
+* @brief Return the cached flowchart of a function without copying it
+*/
+const qflow_chart_t *get_func_flowchart(ea_t ea);
+
 //--------------------------------------------------------------------------
 /**
 * @brief Focuses and jumps to the given node id in the graph viewer
@@ -82,6 +131,12 @@ char *skip_spaces(char *p);
 */
 bool is_ida_gui();
 
+//--------------------------------------------------------------------------
+/**
+* @brief Returns the count of processors (at least 1)
+*/
+int get_cpu_count();
+
 
 //--------------------------------------------------------------------------
 /**
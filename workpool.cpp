@@ -0,0 +1,153 @@
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Work pool module
+
+History
+--------
+
+10/18/2026 - agent              - First version
+--------------------------------------------------------------------------*/
+
+#include "workpool.h"
+
+//--------------------------------------------------------------------------
+/**
+* @brief Take the next job of a worker
+*/
+bool workpool_t::pop(int worker, int *job)
+{
+  range_t &r = ranges[worker];
+  qmutex_lock(r.lock);
+  bool ok = r.begin < r.end;
+  if (ok)
+    *job = r.begin++;
+  qmutex_unlock(r.lock);
+  return ok;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Count of jobs left to a worker
+*/
+int workpool_t::get_left(int worker)
+{
+  range_t &r = ranges[worker];
+  qmutex_lock(r.lock);
+  int left = r.end - r.begin;
+  qmutex_unlock(r.lock);
+  return left;
+}
+
+//--------------------------------------------------------------------------
+/**
+* @brief Move the second half of the largest remaining range to a worker
+* @return false when no job is left
+*/
+bool workpool_t::steal(int worker)
+{
+  int count = int(ranges.size());
+  for (;;)
+  {
+    int victim = -1, best = 0;
+    for (int i=1; i < count; i++)
+    {
+      int v = (worker + i) % count;
+      int left = get_left(v);
+      if (left > best)
+      {
+        best = left;
+        victim = v;
+      }
+    }
+    if (victim == -1)
+      return false;
+
+    // The victim may have run some jobs since its size was read
+    range_t &r = ranges[victim];
+    qmutex_lock(r.lock);
+    int left = r.end - r.begin;
+    int begin = r.end - (left + 1) / 2, end = r.end;
+    if (left > 0)
+      r.end = begin;
+    qmutex_unlock(r.lock);
+
+    if (left > 0)
+    {
+      range_t &own = ranges[worker];
+      qmutex_lock(own.lock);
+      own.begin = begin;
+      own.end = end;
+      qmutex_unlock(own.lock);
+      return true;
+    }
+  }
+}
+
+//--------------------------------------------------------------------------
+void workpool_t::work(int worker)
+{
+  int job;
+  while (pop(worker, &job) || (steal(worker) && pop(worker, &job)))
+    cb(ud, worker, job);
+}
+
+//--------------------------------------------------------------------------
+int idaapi workpool_t::thread_cb(void *ud)
+{
+  worker_t *w = (worker_t *)ud;
+  w->pool->work(w->id);
+  return 0;
+}
+
+//--------------------------------------------------------------------------
+void workpool_t::run(int count, int threads, job_cb_t *cb, void *ud)
+{
+  if (count <= 0)
+    return;
+
+  this->cb = cb;
+  this->ud = ud;
+  threads = qmax(1, qmin(threads, count));
+
+  // Single thread: run the jobs in order
+  if (threads == 1)
+  {
+    for (int job=0; job < count; job++)
+      cb(ud, 0, job);
+    return;
+  }
+
+  ranges.resize(threads);
+  for (int i=0; i < threads; i++)
+  {
+    ranges[i].begin = int(int64(count) * i / threads);
+    ranges[i].end = int(int64(count) * (i + 1) / threads);
+    ranges[i].lock = qmutex_create();
+  }
+
+  qvector<worker_t> workers(threads);
+  qvector<qthread_t> handles;
+  for (int i=1; i < threads; i++)
+  {
+    workers[i].pool = this;
+    workers[i].id = i;
+    qthread_t t = qthread_create(thread_cb, &workers[i]);
+    if (t != NULL)
+      handles.push_back(t);
+  }
+
+  // The calling thread is the first worker. The ranges of the workers that
+  // could not be started are stolen
+  work(0);
+
+  for (size_t i=0; i < handles.size(); i++)
+  {
+    qthread_join(handles[i]);
+    qthread_free(handles[i]);
+  }
+  for (int i=0; i < threads; i++)
+    qmutex_free(ranges[i].lock);
+  ranges.clear();
+}
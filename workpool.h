@@ -0,0 +1,66 @@
+#ifndef __WORKPOOL__
+#define __WORKPOOL__
+
+/*--------------------------------------------------------------------------
+GraphSlick (c) Elias Bachaalany
+-------------------------------------
+
+Work pool module
+
+This module runs a count of independent jobs on worker threads. Each worker
+starts with a contiguous range of jobs and runs them in increasing order.
+A worker without jobs steals the second half of the largest remaining range.
+The jobs must not call the IDA API.
+
+--------------------------------------------------------------------------*/
+
+//--------------------------------------------------------------------------
+#include <pro.h>
+
+//--------------------------------------------------------------------------
+/**
+* @brief Work stealing pool of worker threads
+*/
+class workpool_t
+{
+public:
+  /**
+  * @brief Job callback: runs the job 'job' on the worker 'worker'
+  */
+  typedef void job_cb_t(void *ud, int worker, int job);
+
+private:
+  struct range_t
+  {
+    int begin;
+    int end;
+    qmutex_t lock;
+  };
+  typedef qvector<range_t> range_vec_t;
+
+  struct worker_t
+  {
+    workpool_t *pool;
+    int id;
+  };
+
+  range_vec_t ranges;
+  job_cb_t *cb;
+  void *ud;
+
+  int get_left(int worker);
+  bool pop(int worker, int *job);
+  bool steal(int worker);
+  void work(int worker);
+
+  static int idaapi thread_cb(void *ud);
+
+public:
+  /**
+  * @brief Run the jobs 0..count-1 and return when they are all done
+  * @param threads - count of workers, the calling thread is one of them
+  */
+  void run(int count, int threads, job_cb_t *cb, void *ud);
+};
+
+#endif